@@ -0,0 +1,323 @@
+#pragma once
+
+// Day 1 dial engine. Turning the dial is a step modulo TRACK_SIZE, so how
+// often a run of moves reaches zero depends only on the position the run
+// starts from. A run is summarised as a table over the TRACK_SIZE start
+// positions; summaries of consecutive runs combine associatively, which
+// lets chunks of the log be summarised on separate threads and folded in
+// order afterwards. DialIndex keeps such summaries of every prefix of whole
+// blocks to answer queries about any window of one log.
+
+#include "../common/common.h"
+#include "../common/thread_pool.h"
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace puzzles::day1 {
+
+constexpr int TRACK_SIZE = 100;
+constexpr int START_POSITION = 50;
+
+struct Dial {
+  int position = START_POSITION;
+  uint64_t zero_stops = 0;  // moves ending on zero
+  uint64_t zero_passes = 0; // times zero was reached, stops included
+};
+
+// Signed distance of one "L68" / "R48" line, L moves negative
+constexpr std::optional<int64_t> parseMove(std::string_view line) {
+  if (line.empty())
+    return std::nullopt;
+  char direction = line[0];
+  auto distance = common::to_unsigned<uint64_t>(line.substr(1));
+  if (!distance || *distance > std::numeric_limits<int64_t>::max())
+    return std::nullopt;
+  if (direction == 'L')
+    return -static_cast<int64_t>(*distance);
+  if (direction == 'R')
+    return static_cast<int64_t>(*distance);
+  return std::nullopt; // Invalid direction
+}
+
+constexpr void applyMove(Dial &dial, int64_t move) {
+  const uint64_t distance = move < 0 ? -static_cast<uint64_t>(move) : move;
+  auto rotations = distance / TRACK_SIZE;
+  auto remainder = static_cast<int>(distance % TRACK_SIZE);
+  auto last_position = dial.position;
+  if (move < 0) {
+    dial.position = (dial.position - remainder + TRACK_SIZE) % TRACK_SIZE;
+    if ((dial.position > last_position || dial.position == 0) &&
+        last_position != 0) {
+      rotations++;
+    }
+  } else {
+    dial.position = (dial.position + remainder) % TRACK_SIZE;
+    if (dial.position < last_position) {
+      rotations++;
+    }
+  }
+  dial.zero_stops += (dial.position == 0) ? 1 : 0;
+  dial.zero_passes += rotations;
+}
+
+// Moves as the engine takes them. Every full turn passes zero once wherever
+// the dial is, so full turns are only counted; a move keeps its remainder,
+// -99..99, in one byte.
+struct DecodedMoves {
+  std::vector<int8_t> steps;
+  uint64_t full_turns = 0;
+
+  void push_back(int64_t move) {
+    const uint64_t distance = move < 0 ? -static_cast<uint64_t>(move) : move;
+    const auto step = static_cast<int8_t>(distance % TRACK_SIZE);
+    steps.push_back(move < 0 ? static_cast<int8_t>(-step) : step);
+    full_turns += distance / TRACK_SIZE;
+  }
+
+  void append(DecodedMoves &&other) {
+    steps.insert(steps.end(), other.steps.begin(), other.steps.end());
+    full_turns += other.full_turns;
+  }
+};
+
+// Effect of a run of steps, by the position the dial is at before it
+struct StepsSummary {
+  int net = 0; // the end position is start + net, modulo TRACK_SIZE
+  std::array<uint64_t, TRACK_SIZE> zero_stops{};
+  std::array<uint64_t, TRACK_SIZE> zero_passes{};
+};
+
+// O(steps + TRACK_SIZE): a step reaches zero from a contiguous (cyclic)
+// range of positions, which is one range of start positions shifted by the
+// offset so far, added to a difference array. Stops are a histogram of the
+// offsets after each step.
+constexpr StepsSummary summarize(std::span<const int8_t> steps) {
+  std::array<int64_t, TRACK_SIZE + 1> passes{};
+  std::array<uint64_t, TRACK_SIZE> offsets{};
+  int offset = 0;
+  for (int step : steps) {
+    // An R step of r reaches zero from 100 - r..99, an L step from 1..r
+    const int first = step > 0 ? TRACK_SIZE - step : 1;
+    const int length = step > 0 ? step : -step;
+    const int begin = (first - offset + TRACK_SIZE) % TRACK_SIZE;
+    const int end = begin + length;
+    passes[begin] += 1;
+    if (end <= TRACK_SIZE) {
+      passes[end] -= 1;
+    } else {
+      passes[TRACK_SIZE] -= 1;
+      passes[0] += 1;
+      passes[end - TRACK_SIZE] -= 1;
+    }
+    offset = (offset + step + TRACK_SIZE) % TRACK_SIZE;
+    offsets[offset]++;
+  }
+
+  StepsSummary summary{};
+  summary.net = offset;
+  int64_t hits = 0;
+  for (int start = 0; start < TRACK_SIZE; ++start) {
+    hits += passes[start];
+    summary.zero_passes[start] = static_cast<uint64_t>(hits);
+    summary.zero_stops[start] = offsets[(TRACK_SIZE - start) % TRACK_SIZE];
+  }
+  return summary;
+}
+
+// Summary of `first` followed by `second`
+constexpr StepsSummary combine(const StepsSummary &first,
+                               const StepsSummary &second) {
+  StepsSummary summary{};
+  summary.net = (first.net + second.net) % TRACK_SIZE;
+  for (int start = 0; start < TRACK_SIZE; ++start) {
+    const int middle = (start + first.net) % TRACK_SIZE;
+    summary.zero_stops[start] =
+        first.zero_stops[start] + second.zero_stops[middle];
+    summary.zero_passes[start] =
+        first.zero_passes[start] + second.zero_passes[middle];
+  }
+  return summary;
+}
+
+constexpr void applySummary(Dial &dial, const StepsSummary &summary) {
+  dial.zero_stops += summary.zero_stops[dial.position];
+  dial.zero_passes += summary.zero_passes[dial.position];
+  dial.position = (dial.position + summary.net) % TRACK_SIZE;
+}
+
+// The dial after `moves`: chunks of steps are summarised on the thread pool
+// and their summaries folded in order
+inline Dial turnDial(Dial dial, const DecodedMoves &moves, size_t grain = 0) {
+  const std::span<const int8_t> steps(moves.steps);
+  auto summary = common::parallel_reduce(
+      size_t{0}, steps.size(), StepsSummary{},
+      [steps](size_t lo, size_t hi) {
+        return summarize(steps.subspan(lo, hi - lo));
+      },
+      [](const StepsSummary &first, const StepsSummary &second) {
+        return combine(first, second);
+      },
+      grain);
+  applySummary(dial, summary);
+  dial.zero_passes += moves.full_turns;
+  return dial;
+}
+
+// Moves with the full turns of each one kept, so any window of them can be
+// replayed. Most moves turn less than 65535 times; the others are listed
+// apart.
+class MoveLog {
+  static constexpr uint16_t LargeTurns = 0xffff;
+
+  std::vector<int8_t> steps_;
+  std::vector<uint16_t> turns_;
+  std::vector<std::pair<size_t, uint64_t>> large_turns_; // by move index
+
+public:
+  void push_back(int64_t move) {
+    const uint64_t distance = move < 0 ? -static_cast<uint64_t>(move) : move;
+    const auto step = static_cast<int8_t>(distance % TRACK_SIZE);
+    const uint64_t turns = distance / TRACK_SIZE;
+    if (turns >= LargeTurns) {
+      large_turns_.emplace_back(steps_.size(), turns);
+    }
+    steps_.push_back(move < 0 ? static_cast<int8_t>(-step) : step);
+    turns_.push_back(
+        static_cast<uint16_t>(std::min<uint64_t>(turns, LargeTurns)));
+  }
+
+  void append(MoveLog &&other) {
+    for (auto &[index, turns] : other.large_turns_) {
+      large_turns_.emplace_back(index + steps_.size(), turns);
+    }
+    steps_.insert(steps_.end(), other.steps_.begin(), other.steps_.end());
+    turns_.insert(turns_.end(), other.turns_.begin(), other.turns_.end());
+  }
+
+  size_t size() const { return steps_.size(); }
+  std::span<const int8_t> steps() const { return steps_; }
+
+  // Full turns of moves [first, last)
+  uint64_t turns(size_t first, size_t last) const {
+    uint64_t turns = 0;
+    for (size_t index = first; index < last; ++index) {
+      turns += turns_[index];
+    }
+    // Large ones were counted as LargeTurns above
+    auto by_index = [](const auto &large) { return large.first; };
+    auto large = std::ranges::lower_bound(large_turns_, first, {}, by_index);
+    for (; large != large_turns_.end() && large->first < last; ++large) {
+      turns += large->second - LargeTurns;
+    }
+    return turns;
+  }
+};
+
+// Answers "where does the dial end and how often does it reach zero over
+// moves [first, last) when it starts at `position`" for one log, in O(1) of
+// the log length. The summary of every prefix of whole blocks is kept; the
+// whole blocks of a window are the difference of two of them, looked up at
+// the position the dial would have had at move 0. At most two partial
+// blocks are replayed; with the offset of every move from its block's start
+// kept too, each move of those is checked independently of the others.
+class DialIndex {
+public:
+  static constexpr size_t DefaultBlockSize = 1024;
+
+  explicit DialIndex(MoveLog log, size_t block_size = DefaultBlockSize)
+      : log_(std::move(log)), block_size_(block_size),
+        offsets_(log_.size()) {
+    const auto steps = log_.steps();
+    const size_t blocks = (steps.size() + block_size_ - 1) / block_size_;
+    std::vector<StepsSummary> summaries(blocks);
+    std::vector<uint64_t> turns(blocks);
+    common::parallel_for(size_t{0}, blocks, [&](size_t block) {
+      const size_t first = block * block_size_;
+      const size_t last = std::min(first + block_size_, steps.size());
+      int offset = 0;
+      for (size_t index = first; index < last; ++index) {
+        offsets_[index] = static_cast<uint8_t>(offset);
+        offset = (offset + steps[index] + TRACK_SIZE) % TRACK_SIZE;
+      }
+      summaries[block] = summarize(steps.subspan(first, last - first));
+      turns[block] = log_.turns(first, last);
+    });
+    prefixes_.resize(blocks + 1);
+    prefix_turns_.resize(blocks + 1);
+    for (size_t block = 0; block < blocks; ++block) {
+      prefixes_[block + 1] = combine(prefixes_[block], summaries[block]);
+      prefix_turns_[block + 1] = prefix_turns_[block] + turns[block];
+    }
+  }
+
+  size_t size() const { return log_.size(); }
+
+  // Zero stops and passes of the window only; nullopt for a window outside
+  // the log or a position off the track
+  std::optional<Dial> query(size_t first, size_t last, int position) const {
+    if (first > last || last > size() || position < 0 ||
+        position >= TRACK_SIZE) {
+      return std::nullopt;
+    }
+    Dial dial{.position = position};
+    const size_t first_block = (first + block_size_ - 1) / block_size_;
+    const size_t last_block = last / block_size_;
+    if (first_block > last_block) { // inside one block
+      replay(dial, first, last);
+      return dial;
+    }
+    replay(dial, first, first_block * block_size_);
+    const auto &before = prefixes_[first_block];
+    const auto &after = prefixes_[last_block];
+    const int start = (dial.position - before.net + TRACK_SIZE) % TRACK_SIZE;
+    dial.zero_stops += after.zero_stops[start] - before.zero_stops[start];
+    dial.zero_passes += after.zero_passes[start] - before.zero_passes[start] +
+                        prefix_turns_[last_block] - prefix_turns_[first_block];
+    dial.position = (start + after.net) % TRACK_SIZE;
+    replay(dial, last_block * block_size_, last);
+    return dial;
+  }
+
+private:
+  // Moves [first, last) of one block: the position before each of them is
+  // its offset in the block, shifted by where the dial was at `first`
+  void replay(Dial &dial, size_t first, size_t last) const {
+    if (first == last) {
+      return;
+    }
+    const auto steps = log_.steps();
+    const int shift =
+        (dial.position - offsets_[first] + TRACK_SIZE) % TRACK_SIZE;
+    uint64_t stops = 0;
+    uint64_t passes = 0;
+    for (size_t index = first; index < last; ++index) {
+      int position = shift + offsets_[index];
+      position -= position >= TRACK_SIZE ? TRACK_SIZE : 0;
+      const int step = steps[index];
+      const int next = position + step;
+      // Going right zero is reached by wrapping past TRACK_SIZE, going left
+      // by arriving at or below it from anywhere but zero itself
+      passes += step > 0 ? next >= TRACK_SIZE : next <= 0 && position != 0;
+      stops += next == 0 || next == TRACK_SIZE;
+    }
+    const int end = shift + offsets_[last - 1] + steps[last - 1];
+    dial.position = (end + 2 * TRACK_SIZE) % TRACK_SIZE;
+    dial.zero_stops += stops;
+    dial.zero_passes += passes + log_.turns(first, last);
+  }
+
+  MoveLog log_;
+  size_t block_size_;
+  std::vector<uint8_t> offsets_;       // before each move, from its block's
+  std::vector<StepsSummary> prefixes_; // of moves [0, block * block_size_)
+  std::vector<uint64_t> prefix_turns_;
+};
+
+} // namespace puzzles::day1
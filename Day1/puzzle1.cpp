@@ -8,59 +8,108 @@
  */
 
 #include "../common/common.h"
+#include "../common/embed.h"
+#include "../common/incremental.h"
+#include "../common/registry.h"
+#include "../common/thread_pool.h"
+#include "dial.h"
+#include <expected>
+#include <filesystem>
 #include <iostream>
+#include <optional>
 #include <print>
+#include <span>
 
 namespace {
-constexpr int TRACK_SIZE = 100;
-constexpr int START_POSITION = 50;
-constexpr int MAX_DISTANCE = 1000;
-} // namespace
-
-int main(int argc, char *argv[]) {
+namespace pc = puzzles::common;
+using puzzles::day1::applyMove;
+using puzzles::day1::DecodedMoves;
+using puzzles::day1::Dial;
+using puzzles::day1::parseMove;
 
-  namespace pc = puzzles::common;
-
-  const std::filesystem::path input_file =
-      (argc > 1) ? argv[1] : "../Day1/input";
+// Applies the moves of `text` to the dial; false on a malformed line
+constexpr bool applyText(std::string_view text, Dial &dial) {
+  return pc::forEachLine(text, [&dial](std::string_view line) {
+    if (line.empty())
+      return true;
+    auto move = parseMove(line);
+    if (!move)
+      return false;
+    applyMove(dial, *move);
+    return true;
+  });
+}
 
-  using ResultType = std::tuple<int, int>; // (zero crossings, total rotations)
+// Whole puzzle over text already in memory; nullopt on a malformed line
+constexpr std::optional<Dial> solveText(std::string_view text) {
+  Dial dial{};
+  return applyText(text, dial) ? std::optional(dial) : std::nullopt;
+}
 
-  auto result = pc::readFileByLine<ResultType>(
-      input_file, [](std::string_view line, ResultType &accumulate) -> bool {
-        static int position = START_POSITION;
+// Moves are decoded into one byte each on every thread, then the dial is
+// turned by summarising chunks of them in parallel (see dial.h).
+// readFilePipelined does not fit here: it parses on one thread and merges
+// its per-thread results in thread order, not input order, so only a
+// single solver thread could turn the dial and the scan would never run in
+// parallel. readFileParallel parses the chunks concurrently, and "-" still
+// works, as MappedFile drains standard input into a buffer; the cost is
+// holding the decoded log, one byte per move, instead of streaming it.
+std::expected<Dial, bool> readDial(const std::filesystem::path &input) {
+  auto moves = pc::readFileParallel<DecodedMoves>(
+      input,
+      [](std::string_view line, DecodedMoves &moves) {
         if (line.empty())
           return true;
-
-        char direction = line[0];
-        auto distance = pc::to_unsigned<unsigned>(line.substr(1));
-        if (!distance || *distance > MAX_DISTANCE)
+        auto move = parseMove(line);
+        if (!move)
           return false;
+        moves.push_back(*move);
+        return true;
+      },
+      [](DecodedMoves &into, DecodedMoves &&part) {
+        into.append(std::move(part));
+      },
+      pc::MergeOrder::Ordered, pc::ThreadPool::global().size());
+  if (!moves) {
+    return std::unexpected(false);
+  }
+  return puzzles::day1::turnDial(Dial{}, *moves);
+}
 
-        auto rotations = *distance / TRACK_SIZE;
-        auto remainder = *distance % TRACK_SIZE;
-        auto last_position = position;
-        if (direction == 'L') {
-          position = (position - remainder + TRACK_SIZE) % TRACK_SIZE;
-          if ((position > last_position || position == 0) &&
-              last_position != 0) {
-            rotations++;
-          }
-        } else if (direction == 'R') {
-          position = (position + remainder) % TRACK_SIZE;
-          if (position < last_position) {
-            rotations++;
-          }
-        } else {
-          return false; // Invalid direction
+// The dial where the previous run over this file left it, moved by the
+// lines appended since
+std::expected<Dial, bool> resumeDial(const std::filesystem::path &input) {
+  return pc::incrementalInput<Dial>(
+      "day1", 2, input, applyText,
+      [](const Dial &dial, pc::CacheWriter &state) {
+        state.add(std::span<const Dial>(&dial, 1));
+      },
+      [](const pc::CacheReader &state) -> std::expected<Dial, bool> {
+        auto dial = state.section<Dial>(0);
+        if (!dial || dial->size() != 1) {
+          return std::unexpected(false);
         }
-        std::get<0>(accumulate) += (position == 0) ? 1 : 0;
-        std::get<1>(accumulate) += rotations;
-        return true;
+        return dial->front();
       });
+}
+
+int solve(const pc::SolverContext &ctx) {
+#ifdef PUZZLES_HAS_EMBEDDED_INPUT
+  if (ctx.input == PUZZLES_DEFAULT_INPUT) {
+    static constexpr auto answer = solveText(pc::embeddedInput());
+    static_assert(answer, "Embedded input is malformed");
+    std::println(ctx.out, "{} {}", answer->zero_stops, answer->zero_passes);
+    return 0;
+  }
+#endif
+
+  // With $PUZZLES_STATE_DIR set only lines appended since the last run over
+  // the file are parsed
+  auto result = pc::incrementalMode(ctx.input) ? resumeDial(ctx.input)
+                                               : readDial(ctx.input);
 
   if (result) {
-    std::println("{} {}", std::get<0>(*result), std::get<1>(*result));
+    std::println(ctx.out, "{} {}", result->zero_stops, result->zero_passes);
   } else {
     std::println(stderr, pc::InputFileError);
     return 1;
@@ -68,3 +117,6 @@ int main(int argc, char *argv[]) {
 
   return 0;
 }
+} // namespace
+
+PUZZLES_REGISTER_SOLVER("puzzle1", solve)
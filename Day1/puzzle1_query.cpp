@@ -0,0 +1,138 @@
+/*
+ * Window queries over a Day 1 rotation log
+ * Indexes one log once (see DialIndex in dial.h), then answers every query
+ * of a batch: how often the dial stops on and reaches zero over moves
+ * [first, last) when it starts at `position`, and where it ends.
+ * Usage:
+ *   puzzle1_query <log> <queries>
+ * Each query line is "first last position", with moves counted from 0; each
+ * answer line is "zero_stops zero_passes end_position". Either file may be
+ * "-" for standard input, but not both. Index and query throughput go to
+ * stderr.
+ */
+
+#include "../common/common.h"
+#include "../common/thread_pool.h"
+#include "dial.h"
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <expected>
+#include <filesystem>
+#include <format>
+#include <optional>
+#include <print>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+namespace pc = puzzles::common;
+using puzzles::day1::Dial;
+using puzzles::day1::DialIndex;
+using puzzles::day1::MoveLog;
+using puzzles::day1::parseMove;
+using puzzles::day1::TRACK_SIZE;
+
+struct WindowQuery {
+  size_t first;
+  size_t last;
+  int position;
+};
+
+std::expected<MoveLog, bool> readLog(const std::filesystem::path &input) {
+  return pc::readFileParallel<MoveLog>(
+      input,
+      [](std::string_view line, MoveLog &log) {
+        if (line.empty())
+          return true;
+        auto move = parseMove(line);
+        if (!move) {
+          std::println(stderr, "Invalid move: {}", line);
+          return false;
+        }
+        log.push_back(*move);
+        return true;
+      },
+      [](MoveLog &into, MoveLog &&part) { into.append(std::move(part)); },
+      pc::MergeOrder::Ordered, pc::ThreadPool::global().size());
+}
+
+std::expected<std::vector<WindowQuery>, bool>
+readQueries(const std::filesystem::path &input) {
+  return pc::readFileByLineMapped<std::vector<WindowQuery>>(
+      input, [](std::string_view line, std::vector<WindowQuery> &queries) {
+        if (line.empty())
+          return true;
+        std::array<uint64_t, 3> fields{};
+        auto count = pc::parse_integers(line, std::span(fields));
+        // The position is narrowed to int below, so it is range checked
+        // first rather than wrapping to some other position
+        if (!count || *count != fields.size() || fields[2] >= TRACK_SIZE) {
+          std::println(stderr, "Invalid query: {}", line);
+          return false;
+        }
+        queries.push_back({fields[0], fields[1], static_cast<int>(fields[2])});
+        return true;
+      });
+}
+
+double millisecondsSince(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double, std::milli>(
+             std::chrono::steady_clock::now() - start)
+      .count();
+}
+} // namespace
+
+int main(int argc, char *argv[]) {
+  if (argc != 3) {
+    std::println(stderr, "Usage: puzzle1_query <log> <queries>");
+    return 1;
+  }
+  if (std::string_view(argv[1]) == "-" && std::string_view(argv[2]) == "-") {
+    std::println(stderr, "Only one of <log> and <queries> can be \"-\"");
+    return 1;
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  auto log = readLog(argv[1]);
+  if (!log) {
+    std::println(stderr, pc::InputFileError);
+    return 1;
+  }
+  const DialIndex index(std::move(*log));
+  std::println(stderr, "Indexed {} moves in {:.1f} ms", index.size(),
+               millisecondsSince(start));
+
+  auto queries = readQueries(argv[2]);
+  if (!queries) {
+    std::println(stderr, "Error reading queries {}", argv[2]);
+    return 1;
+  }
+
+  start = std::chrono::steady_clock::now();
+  std::vector<std::optional<Dial>> answers(queries->size());
+  pc::parallel_for(size_t{0}, queries->size(), [&](size_t i) {
+    const auto &query = (*queries)[i];
+    answers[i] = index.query(query.first, query.last, query.position);
+  });
+  const double elapsed = millisecondsSince(start);
+
+  std::string out;
+  for (size_t i = 0; i < answers.size(); ++i) {
+    if (!answers[i]) {
+      std::println(stderr, "Query {} is outside the log of {} moves", i + 1,
+                   index.size());
+      return 1;
+    }
+    out += std::format("{} {} {}\n", answers[i]->zero_stops,
+                       answers[i]->zero_passes, answers[i]->position);
+  }
+  std::fwrite(out.data(), 1, out.size(), stdout);
+  std::println(stderr, "Answered {} queries in {:.1f} ms ({:.0f} queries/s)",
+               answers.size(), elapsed,
+               elapsed > 0 ? 1000.0 * answers.size() / elapsed : 0.0);
+  return 0;
+}
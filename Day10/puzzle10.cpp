@@ -4,16 +4,24 @@
  * Using Gaussian elimination over GF(2) to minimize button presses
  * Expected output: 517
  */
+#include "../common/cache.h"
 #include "../common/common.h"
+#include "../common/registry.h"
+#include "../common/stream.h"
+#include "../common/thread_pool.h"
 #include <algorithm>
+#include <array>
 #include <bitset>
+#include <cstdint>
+#include <filesystem>
 #include <iostream>
 #include <print>
 #include <ranges>
-#include <regex>
+#include <span>
 #include <string>
 #include <vector>
 
+namespace {
 namespace ranges = std::ranges;
 namespace views = std::views;
 
@@ -25,55 +33,68 @@ struct Machine {
   size_t num_lights;
 };
 
+// All machines of the input in two flat arrays, which is also the layout of
+// the parsed input cache
+struct MachineRecord {
+  uint64_t target;
+  uint32_t num_lights;
+  uint32_t first_button; // index into MachineList::buttons
+  uint32_t button_count;
+  uint32_t reserved;
+};
+
+struct MachineList {
+  std::vector<MachineRecord> machines;
+  std::vector<uint64_t> buttons;
+};
+
 // Parse a single machine line
 std::expected<Machine, bool> parseMachine(std::string_view line) {
-  Machine machine;
-
-  // Extract target configuration [.##.#...]
-  std::regex target_regex(R"(\[([.#]+)\])");
-  std::regex buttons_regex(R"(\(([0-9,]+)\))");
-
-  std::string line_str(line);
-  std::smatch match;
-
-  // Parse target
-  if (std::regex_search(line_str, match, target_regex)) {
-    std::string target_str = match[1].str();
-    machine.num_lights = target_str.size();
-    for (size_t i = 0; i < target_str.size(); ++i) {
-      if (target_str[i] == '#') {
-        machine.target.set(i);
+  namespace pc = puzzles::common;
+  Machine machine{};
+  bool has_target = false;
+
+  // [.##.#...] target configuration, (0,2,3) buttons, {..} joltage (unused)
+  size_t pos = 0;
+  while (auto group = pc::next_group(line, pos)) {
+    if (group->open == '[') {
+      if (group->body.empty() || group->body.size() > MAX_LIGHTS) {
+        return std::unexpected(false);
+      }
+      machine.num_lights = group->body.size();
+      for (size_t i = 0; i < group->body.size(); ++i) {
+        if (group->body[i] == '#') {
+          machine.target.set(i);
+        }
       }
+      has_target = true;
+    } else if (group->open == '(') {
+      std::array<size_t, MAX_LIGHTS> indices{};
+      auto count = pc::parse_integers(group->body, std::span(indices));
+      if (!count || *count == 0) {
+        return std::unexpected(false);
+      }
+      std::bitset<MAX_LIGHTS> button;
+      for (size_t idx : std::span(indices).first(*count)) {
+        if (idx >= MAX_LIGHTS) {
+          return std::unexpected(false);
+        }
+        button.set(idx);
+      }
+      machine.buttons.push_back(button);
     }
-  } else {
-    return std::unexpected(false);
   }
 
-  // Parse buttons
-  auto buttons_begin =
-      std::sregex_iterator(line_str.begin(), line_str.end(), buttons_regex);
-  auto buttons_end = std::sregex_iterator();
-
-  for (auto it = buttons_begin; it != buttons_end; ++it) {
-    std::smatch button_match = *it;
-    std::string button_str = button_match[1].str();
-
-    std::bitset<MAX_LIGHTS> button;
-    std::istringstream iss(button_str);
-    std::string num;
-    while (std::getline(iss, num, ',')) {
-      size_t idx = std::stoull(num);
-      button.set(idx);
-    }
-    machine.buttons.push_back(button);
+  if (!has_target) {
+    return std::unexpected(false);
   }
-
   return machine;
 }
 
 // Solve using Gaussian elimination over GF(2) with optimization for minimum
 // presses
 size_t solveMachine(const Machine &machine) {
+  PUZZLES_TRACE_SCOPE("solve machine");
   size_t n = machine.num_lights;
   size_t m = machine.buttons.size();
 
@@ -186,37 +207,150 @@ size_t solveMachine(const Machine &machine) {
   return min_presses;
 }
 
-int main(int argc, char *argv[]) {
-  std::string input_file = (argc > 1) ? argv[1] : "../Day 10/input";
-
+std::expected<MachineList, bool>
+readMachines(const std::filesystem::path &input) {
   namespace pc = puzzles::common;
-  auto result = pc::readFileByLine<size_t>(
-      input_file, [](std::string_view line, size_t &total) -> bool {
+  // Lines are parsed in parallel chunks and appended in file order
+  return pc::readFileParallel<MachineList>(
+      input,
+      [](std::string_view line, MachineList &list) -> bool {
         if (line.empty())
           return true;
 
-        auto machine_result = parseMachine(line);
-        if (!machine_result) {
+        auto machine = parseMachine(line);
+        if (!machine) {
           std::println(stderr, "Failed to parse machine");
           return false;
         }
+        list.machines.push_back(
+            {machine->target.to_ullong(),
+             static_cast<uint32_t>(machine->num_lights),
+             static_cast<uint32_t>(list.buttons.size()),
+             static_cast<uint32_t>(machine->buttons.size()), 0});
+        for (const auto &button : machine->buttons) {
+          list.buttons.push_back(button.to_ullong());
+        }
+        return true;
+      },
+      [](MachineList &list, MachineList &&part) {
+        for (auto machine : part.machines) {
+          machine.first_button += static_cast<uint32_t>(list.buttons.size());
+          list.machines.push_back(machine);
+        }
+        list.buttons.insert(list.buttons.end(), part.buttons.begin(),
+                            part.buttons.end());
+      },
+      pc::MergeOrder::Ordered);
+}
 
-        size_t presses = solveMachine(*machine_result);
-        if (presses == SIZE_MAX) {
-          std::println(stderr, "No solution found for machine");
-          return false;
+// SIZE_MAX marks a machine without a solution and wins every combine
+size_t combinePresses(size_t into, size_t part) {
+  return into == SIZE_MAX || part == SIZE_MAX ? SIZE_MAX : into + part;
+}
+
+std::expected<MachineList, bool>
+loadMachines(const std::filesystem::path &input) {
+  namespace pc = puzzles::common;
+  return pc::cachedInput<MachineList>(
+      "day10", 1, input, readMachines,
+      [](const MachineList &list, pc::CacheWriter &cache) {
+        cache.add(list.machines);
+        cache.add(list.buttons);
+      },
+      [](const pc::CacheReader &cache) -> std::expected<MachineList, bool> {
+        auto machines = cache.vector<MachineRecord>(0);
+        auto buttons = cache.vector<uint64_t>(1);
+        if (!machines || !buttons) {
+          return std::unexpected(false);
+        }
+        // solveLoaded slices the buttons without checking
+        for (const auto &record : *machines) {
+          if (record.num_lights > MAX_LIGHTS ||
+              size_t{record.first_button} + record.button_count >
+                  buttons->size()) {
+            return std::unexpected(false);
+          }
         }
+        return MachineList{std::move(*machines), std::move(*buttons)};
+      });
+}
+
+// Whole input parsed (or loaded from the cache) first, machines solved in
+// parallel afterwards
+std::expected<size_t, bool> solveLoaded(const std::filesystem::path &input) {
+  namespace pc = puzzles::common;
+  auto result = loadMachines(input);
+  if (!result) {
+    return std::unexpected(false);
+  }
+
+  const auto &list = *result;
+  return pc::parallel_reduce(
+      size_t{0}, list.machines.size(), size_t{0},
+      [&list](size_t first, size_t last) {
+        size_t presses = 0;
+        Machine machine{};
+        for (const auto &record :
+             std::span(list.machines).subspan(first, last - first)) {
+          machine.target = record.target;
+          machine.num_lights = record.num_lights;
+          auto buttons = std::span(list.buttons)
+                             .subspan(record.first_button, record.button_count);
+          machine.buttons.assign(buttons.begin(), buttons.end());
+          presses = combinePresses(presses, solveMachine(machine));
+        }
+        return presses;
+      },
+      combinePresses);
+}
+
+// Machines solved on worker threads while the rest of the input is still
+// being read and parsed
+std::expected<size_t, bool> solveStreamed(const std::filesystem::path &input) {
+  namespace pc = puzzles::common;
+  return pc::readFilePipelined<Machine, size_t>(
+      input,
+      [](std::string_view line, std::vector<Machine> &machines) {
+        if (line.empty())
+          return true;
 
-        total += presses;
+        auto machine = parseMachine(line);
+        if (!machine) {
+          std::println(stderr, "Failed to parse machine");
+          return false;
+        }
+        machines.push_back(std::move(*machine));
         return true;
-      });
+      },
+      [](std::span<const Machine> machines, size_t &presses) {
+        for (const auto &machine : machines) {
+          presses = combinePresses(presses, solveMachine(machine));
+        }
+        return true;
+      },
+      [](size_t &into, size_t &&part) { into = combinePresses(into, part); },
+      pc::PipelineOptions{.batch_records = 8});
+}
 
-  if (result) {
-    std::println("Total button presses: {}", *result);
-  } else {
+int solve(const puzzles::common::SolverContext &ctx) {
+  namespace pc = puzzles::common;
+  // The cache only pays off when parsing is skipped, so without one (and
+  // for standard input, which is never cached) parsing overlaps the solving
+  auto total = pc::cacheDirectory() && !pc::isStandardInput(ctx.input)
+                   ? solveLoaded(ctx.input)
+                   : solveStreamed(ctx.input);
+  if (!total) {
     std::println(stderr, pc::InputFileError);
     return 1;
   }
+  if (*total == SIZE_MAX) {
+    std::println(stderr, "No solution found for machine");
+    return 1;
+  }
 
+  std::println(ctx.out, "Total button presses: {}", *total);
   return 0;
 }
+} // namespace
+
+PUZZLES_REGISTER_SOLVER("puzzle10", solve)
@@ -5,17 +5,22 @@
  * Expected output: Total button presses: 21469
  */
 #include <algorithm>
+#include <array>
 #include <expected>
 #include <fstream>
 #include <glpk.h>
 #include <iostream>
 #include <print>
-#include <regex>
-#include <sstream>
+#include <span>
 #include <string>
 #include <vector>
 
 #include "../common/common.h"
+#include "../common/registry.h"
+
+namespace {
+// Upper bound on the number of values inside one (..) or {..} group
+constexpr size_t MAX_FIELDS = 64;
 
 struct Machine {
   std::vector<size_t> target_joltage;
@@ -24,44 +29,33 @@ struct Machine {
 
 // Parse a single machine line
 std::expected<Machine, bool> parseMachine(std::string_view line) {
+  namespace pc = puzzles::common;
   Machine machine;
-
-  std::string line_str(line);
-
-  // Parse buttons (0,1,2) format
-  std::regex buttons_regex(R"(\(([0-9,]+)\))");
-  auto buttons_begin =
-      std::sregex_iterator(line_str.begin(), line_str.end(), buttons_regex);
-  auto buttons_end = std::sregex_iterator();
-
-  for (auto it = buttons_begin; it != buttons_end; ++it) {
-    std::smatch button_match = *it;
-    std::string button_str = button_match[1].str();
-
-    std::vector<size_t> button;
-    std::istringstream iss(button_str);
-    std::string num;
-    while (std::getline(iss, num, ',')) {
-      button.push_back(std::stoull(num));
+  bool has_target = false;
+
+  // Buttons in (0,1,2) format, target joltage in {3,5,4,7} format
+  std::array<size_t, MAX_FIELDS> fields{};
+  size_t pos = 0;
+  while (auto group = pc::next_group(line, pos)) {
+    if (group->open != '(' && group->open != '{') {
+      continue;
+    }
+    auto count = pc::parse_integers(group->body, std::span(fields));
+    if (!count || *count == 0) {
+      return std::unexpected(false);
+    }
+    std::vector<size_t> values(fields.begin(), fields.begin() + *count);
+    if (group->open == '(') {
+      machine.buttons.push_back(std::move(values));
+    } else {
+      machine.target_joltage = std::move(values);
+      has_target = true;
     }
-    machine.buttons.push_back(button);
   }
 
-  // Parse target joltage {3,5,4,7} format
-  std::regex target_regex(R"(\{([0-9,]+)\})");
-  std::smatch match;
-
-  if (std::regex_search(line_str, match, target_regex)) {
-    std::string target_str = match[1].str();
-    std::istringstream iss(target_str);
-    std::string num;
-    while (std::getline(iss, num, ',')) {
-      machine.target_joltage.push_back(std::stoull(num));
-    }
-  } else {
+  if (!has_target) {
     return std::unexpected(false);
   }
-
   return machine;
 }
 
@@ -123,6 +117,7 @@ struct GLP {
 
 // Solve using GLPK Integer Linear Programming
 std::expected<size_t, bool> solveMachine(const Machine &machine) {
+  PUZZLES_TRACE_SCOPE("solve machine");
   size_t num_counters = machine.target_joltage.size();
   size_t num_buttons = machine.buttons.size();
 
@@ -195,13 +190,11 @@ std::expected<size_t, bool> solveMachine(const Machine &machine) {
   return result;
 }
 
-int main(int argc, char *argv[]) {
-  std::string input_file = (argc > 1) ? argv[1] : "../../Day10/input";
-
+int solve(const puzzles::common::SolverContext &ctx) {
   namespace pc = puzzles::common;
 
   auto result = pc::readFileByLine<size_t>(
-      input_file, [](std::string_view line, size_t &total) -> bool {
+      ctx.input, [&ctx](std::string_view line, size_t &total) -> bool {
         size_t machine_num = 0;
 
         if (line.empty())
@@ -221,7 +214,8 @@ int main(int argc, char *argv[]) {
           return false;
         }
 
-        std::println("Machine {} requires {} presses", machine_num, *presses);
+        std::println(ctx.out, "Machine {} requires {} presses", machine_num,
+                     *presses);
         total += *presses;
         return true;
       });
@@ -229,6 +223,9 @@ int main(int argc, char *argv[]) {
     std::println(stderr, pc::InputFileError);
   }
 
-  std::println("Total button presses: {}", *result);
+  std::println(ctx.out, "Total button presses: {}", *result);
   return 0;
 }
+} // namespace
+
+PUZZLES_REGISTER_SOLVER("puzzle10_2_glpk", solve)
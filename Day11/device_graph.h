@@ -0,0 +1,161 @@
+#pragma once
+
+// Device graph of Day 11 shared by both parts: devices are numbered in order
+// of first appearance and the outputs are stored in compressed sparse row
+// form, which is also the layout of the parsed input cache.
+
+#include "../common/cache.h"
+#include "../common/common.h"
+#include <cstdint>
+#include <expected>
+#include <filesystem>
+#include <functional>
+#include <memory_resource>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace puzzles::day11 {
+
+constexpr uint32_t DeviceGraphSchema = 1;
+
+struct DeviceGraph {
+  // Outputs of device i are targets[offsets[i], offsets[i + 1])
+  std::vector<uint32_t> offsets;
+  std::vector<uint32_t> targets;
+  // Name of device i is names[name_offsets[i], name_offsets[i + 1])
+  std::vector<uint32_t> name_offsets;
+  std::vector<char> names;
+
+  size_t size() const { return offsets.empty() ? 0 : offsets.size() - 1; }
+
+  std::span<const uint32_t> outputs(uint32_t device) const {
+    return std::span(targets).subspan(offsets[device],
+                                      offsets[device + 1] - offsets[device]);
+  }
+
+  std::string_view name(uint32_t device) const {
+    return {names.data() + name_offsets[device],
+            name_offsets[device + 1] - name_offsets[device]};
+  }
+
+  // Linear scan, only used for the handful of named devices
+  std::optional<uint32_t> find(std::string_view device) const {
+    for (uint32_t i = 0; i < size(); ++i) {
+      if (name(i) == device) {
+        return i;
+      }
+    }
+    return std::nullopt;
+  }
+};
+
+// Device names are looked up by string_view, no temporary strings
+struct NameHash {
+  using is_transparent = void;
+  size_t operator()(std::string_view name) const {
+    return std::hash<std::string_view>{}(name);
+  }
+};
+
+// Lines "name: out1 out2 ...". A device listed twice keeps its last list.
+inline std::expected<DeviceGraph, bool>
+readDeviceGraph(const std::filesystem::path &input) {
+  namespace pc = puzzles::common;
+  // Name table and adjacency lists are scratch, the arena drops them at once
+  pc::InputArena arena(input, 16);
+  struct Parsed {
+    std::pmr::unordered_map<std::string_view, uint32_t, NameHash,
+                            std::equal_to<>>
+        ids;
+    std::pmr::vector<std::pmr::vector<uint32_t>> outputs;
+    DeviceGraph graph;
+  };
+
+  auto result = pc::readFileByLineMapped<Parsed>(
+      input,
+      [](std::string_view line, Parsed &parsed) -> bool {
+        if (line.empty())
+          return true;
+        size_t colon = line.find(':');
+        if (colon == std::string_view::npos)
+          return true;
+
+        // Map keys point into the mapped input, which outlives the read;
+        // the graph keeps its own copy of every name
+        auto intern = [&parsed](std::string_view name) {
+          auto it = parsed.ids.find(name);
+          if (it != parsed.ids.end()) {
+            return it->second;
+          }
+          auto &graph = parsed.graph;
+          auto id = static_cast<uint32_t>(parsed.outputs.size());
+          graph.name_offsets.push_back(
+              static_cast<uint32_t>(graph.names.size()));
+          graph.names.insert(graph.names.end(), name.begin(), name.end());
+          parsed.ids.emplace(name, id);
+          parsed.outputs.emplace_back();
+          return id;
+        };
+
+        uint32_t device = intern(line.substr(0, colon));
+        std::string_view rest = line.substr(colon + 1);
+        parsed.outputs[device].clear();
+        size_t pos = 0;
+        for (auto tok = pc::next_word(rest, pos); !tok.empty();
+             tok = pc::next_word(rest, pos)) {
+          uint32_t target = intern(tok);
+          parsed.outputs[device].push_back(target);
+        }
+        return true;
+      },
+      Parsed{decltype(Parsed::ids)(arena.resource()),
+             decltype(Parsed::outputs)(arena.resource()),
+             {}});
+  if (!result) {
+    return std::unexpected(false);
+  }
+
+  DeviceGraph &graph = result->graph;
+  graph.name_offsets.push_back(static_cast<uint32_t>(graph.names.size()));
+  graph.offsets.reserve(result->outputs.size() + 1);
+  graph.offsets.push_back(0);
+  for (const auto &outputs : result->outputs) {
+    graph.targets.insert(graph.targets.end(), outputs.begin(), outputs.end());
+    graph.offsets.push_back(static_cast<uint32_t>(graph.targets.size()));
+  }
+  return std::move(graph);
+}
+
+// Parsed graph, from the cache when this input was seen before
+inline std::expected<DeviceGraph, bool>
+loadDeviceGraph(const std::filesystem::path &input) {
+  namespace pc = puzzles::common;
+  return pc::cachedInput<DeviceGraph>(
+      "day11", DeviceGraphSchema, input, readDeviceGraph,
+      [](const DeviceGraph &graph, pc::CacheWriter &cache) {
+        cache.add(graph.offsets);
+        cache.add(graph.targets);
+        cache.add(graph.name_offsets);
+        cache.add(graph.names);
+      },
+      [](const pc::CacheReader &cache) -> std::expected<DeviceGraph, bool> {
+        auto offsets = cache.vector<uint32_t>(0);
+        auto targets = cache.vector<uint32_t>(1);
+        auto name_offsets = cache.vector<uint32_t>(2);
+        auto names = cache.vector<char>(3);
+        if (!offsets || !targets || !name_offsets || !names ||
+            offsets->empty() || offsets->size() != name_offsets->size() ||
+            offsets->back() != targets->size() ||
+            name_offsets->back() != names->size()) {
+          return std::unexpected(false);
+        }
+        return DeviceGraph{std::move(*offsets), std::move(*targets),
+                           std::move(*name_offsets), std::move(*names)};
+      });
+}
+
+} // namespace puzzles::day11
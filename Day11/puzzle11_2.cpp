@@ -4,102 +4,83 @@
  * Count distinct paths from 'svr' to 'out' that pass through both 'dac' and
  * 'fft' Expected output: 390108778818526
  */
-#include <algorithm>
-#include <cstdlib>
+#include <array>
+#include <cstdint>
 #include <iostream>
 #include <print>
-#include <sstream>
-#include <string>
-#include <unordered_map>
-#include <unordered_set>
 #include <vector>
 
 #include "../common/common.h"
+#include "../common/registry.h"
+#include "device_graph.h"
 
+namespace {
 using Count = unsigned __int128;
+using puzzles::day11::DeviceGraph;
+
+constexpr Count Unknown = static_cast<Count>(-1);
+constexpr uint32_t NoDevice = UINT32_MAX;
+
+// Devices that change the search state
+struct Landmarks {
+  uint32_t out = NoDevice;
+  uint32_t dac = NoDevice;
+  uint32_t fft = NoDevice;
+};
 
 // mask bits: bit0 = saw_dac, bit1 = saw_fft
-Count dfs_masked(
-    const std::string &node,
-    const std::unordered_map<std::string, std::vector<std::string>> &g,
-    int mask, std::unordered_set<std::string> &onpath,
-    std::unordered_map<std::string, std::array<Count, 4>> &memo) {
-  if (node == "out") {
+Count dfs_masked(uint32_t node, const DeviceGraph &g, const Landmarks &marks,
+                 int mask, std::vector<char> &onpath,
+                 std::vector<std::array<Count, 4>> &memo) {
+  if (node == marks.out) {
     return (mask == 3) ? 1 : 0;
   }
 
-  if (onpath.find(node) != onpath.end())
+  if (onpath[node])
     return 0; // break cycles
 
   auto &memo_row = memo[node];
-  if (memo_row[mask] != static_cast<Count>(-1))
+  if (memo_row[mask] != Unknown)
     return memo_row[mask];
 
-  auto git = g.find(node);
-  if (git == g.end()) {
-    memo_row[mask] = 0;
-    return 0;
-  }
-
-  onpath.insert(node);
+  onpath[node] = 1;
   Count sum = 0;
-  for (const auto &nbr : git->second) {
+  for (uint32_t nbr : g.outputs(node)) {
     int next_mask = mask;
-    if (nbr == "dac")
+    if (nbr == marks.dac)
       next_mask |= 1;
-    if (nbr == "fft")
+    if (nbr == marks.fft)
       next_mask |= 2;
-    sum += dfs_masked(nbr, g, next_mask, onpath, memo);
+    sum += dfs_masked(nbr, g, marks, next_mask, onpath, memo);
   }
-  onpath.erase(node);
+  onpath[node] = 0;
 
   memo_row[mask] = sum;
   return sum;
 }
 
-int main(int argc, char **argv) {
-  std::filesystem::path input_path =
-      (argc > 1) ? argv[1] : std::filesystem::path("../Day11/input");
-
-  using Graph = std::unordered_map<std::string, std::vector<std::string>>;
-  auto res = puzzles::common::readFileByLine<Graph>(
-      input_path, [](std::string_view line, Graph &g) -> bool {
-        std::string_view s = line;
-        while (!s.empty() && (s.back() == '\r' || s.back() == '\n'))
-          s.remove_suffix(1);
-        if (s.empty())
-          return true;
-        size_t colon = s.find(':');
-        if (colon == std::string_view::npos)
-          return true;
-        std::string name(std::string(s.substr(0, colon)));
-        std::string_view rest = s.substr(colon + 1);
-        std::vector<std::string> outs;
-        std::istringstream iss{std::string(rest)};
-        std::string tok;
-        while (iss >> tok)
-          outs.push_back(tok);
-        g[name] = std::move(outs);
-        return true;
-      });
-
+int solve(const puzzles::common::SolverContext &ctx) {
+  auto res = puzzles::day11::loadDeviceGraph(ctx.input);
   if (!res) {
     std::println(stderr, puzzles::common::InputFileError);
     return 2;
   }
 
-  Graph g = *res;
-  std::unordered_set<std::string> onpath;
-  std::unordered_map<std::string, std::array<Count, 4>> memo;
+  PUZZLES_TRACE_SCOPE("count paths");
+  const DeviceGraph &g = *res;
+  std::vector<char> onpath(g.size(), 0);
+  std::vector<std::array<Count, 4>> memo(
+      g.size(), {Unknown, Unknown, Unknown, Unknown});
 
-  // initialize memo with -1 sentinel
-  for (const auto &p : g)
-    memo[p.first].fill(static_cast<Count>(-1));
-  // ensure special nodes exist in memo map even if no outgoing edges
-  memo["out"].fill(static_cast<Count>(-1));
+  Landmarks marks{g.find("out").value_or(NoDevice),
+                  g.find("dac").value_or(NoDevice),
+                  g.find("fft").value_or(NoDevice)};
+  auto svr = g.find("svr");
+  Count answer = svr ? dfs_masked(*svr, g, marks, 0, onpath, memo) : 0;
 
-  Count answer = dfs_masked("svr", g, 0, onpath, memo);
-
-  std::println("{}", answer);
+  std::println(ctx.out, "{}", answer);
   return 0;
 }
+} // namespace
+
+PUZZLES_REGISTER_SOLVER("puzzle11_2", solve)
@@ -5,34 +5,47 @@
  * Expected output: 490
  */
 #include <algorithm>
+#include <array>
 #include <cstdint>
+#include <expected>
 #include <filesystem>
+#include <functional>
 #include <iostream>
+#include <memory_resource>
 #include <optional>
 #include <print>
 #include <set>
+#include <span>
 #include <string>
 #include <tuple>
 #include <unordered_set>
 #include <vector>
 
+#include "../common/cache.h"
 #include "../common/common.h"
+#include "../common/registry.h"
+#include "../common/thread_pool.h"
 
 namespace {
 using Coord = std::pair<int64_t, int64_t>;
 
+// Width, height and per-shape counts of a region line
+constexpr size_t MAX_REGION_FIELDS = 64;
+
 std::vector<std::string> trim_empty_tail(std::vector<std::string> s) {
   while (!s.empty() && s.back().empty())
     s.pop_back();
   return s;
 }
 
-std::vector<std::vector<std::string>>
-parse_shapes(const std::vector<std::string> &lines) {
+using Lines = std::span<const std::pmr::string>;
+using Region = std::tuple<int, int, std::pmr::vector<int>>;
+
+std::vector<std::vector<std::string>> parse_shapes(Lines lines) {
   std::vector<std::vector<std::string>> shapes;
   size_t i = 0;
   while (i < lines.size()) {
-    std::string line = lines[i];
+    std::string_view line = lines[i];
     if (line.empty()) {
       ++i;
       continue;
@@ -48,7 +61,7 @@ parse_shapes(const std::vector<std::string> &lines) {
     ++i;
     std::vector<std::string> block;
     while (i < lines.size() && !lines[i].empty()) {
-      block.push_back(lines[i]);
+      block.emplace_back(lines[i]);
       ++i;
     }
     shapes.push_back(trim_empty_tail(block));
@@ -56,9 +69,9 @@ parse_shapes(const std::vector<std::string> &lines) {
   return shapes;
 }
 
-std::vector<std::tuple<int, int, std::vector<int>>>
-parse_regions(const std::vector<std::string> &lines) {
-  std::vector<std::tuple<int, int, std::vector<int>>> regions;
+std::pmr::vector<Region> parse_regions(Lines lines,
+                                       std::pmr::memory_resource *resource) {
+  std::pmr::vector<Region> regions(resource);
   for (auto &ln : lines) {
     if (ln.empty())
       continue;
@@ -66,22 +79,16 @@ parse_regions(const std::vector<std::string> &lines) {
     auto pos = ln.find(":");
     if (pos == std::string::npos)
       continue;
-    std::string lhs = ln.substr(0, pos);
-    std::string rhs = ln.substr(pos + 1);
-    auto xpos = lhs.find('x');
-    if (xpos == std::string::npos)
+    if (std::string_view(ln).substr(0, pos).find('x') == std::string::npos)
       continue;
-    int W = std::stoi(lhs.substr(0, xpos));
-    int H = std::stoi(lhs.substr(xpos + 1));
-    // parse counts
-    std::vector<int> counts;
-    {
-      std::istringstream iss(rhs);
-      int v;
-      while (iss >> v)
-        counts.push_back(v);
-    }
-    regions.emplace_back(W, H, counts);
+    // W, H and the counts in one pass
+    std::array<int, MAX_REGION_FIELDS> fields{};
+    auto parsed = puzzles::common::parse_integers(ln, std::span(fields));
+    if (!parsed || *parsed < 2)
+      continue;
+    std::pmr::vector<int> counts(fields.begin() + 2, fields.begin() + *parsed,
+                                 resource);
+    regions.emplace_back(fields[0], fields[1], std::move(counts));
   }
   return regions;
 }
@@ -149,23 +156,25 @@ generate_orientations(const std::vector<std::string> &shape) {
 }
 
 // Attempt to place all pieces using bitmask (if W*H<=64) or board array
-// fallback
+// fallback. All scratch storage comes from resource, which the caller
+// recycles between regions.
 bool can_pack_region(
     int W, int H,
     const std::vector<std::vector<std::vector<Coord>>> &shape_orients,
-    const std::vector<int> &piece_list) {
+    std::span<const int> piece_list, std::pmr::memory_resource *resource) {
   int cells = W * H;
   bool use_mask = (cells <= 64);
 
   // precompute placements per shape index
   int S = (int)shape_orients.size();
-  std::vector<std::vector<uint64_t>> placements_mask(S);
-  std::vector<std::vector<std::vector<int>>> placements_vec(S);
+  std::pmr::vector<std::pmr::vector<uint64_t>> placements_mask(S, resource);
+  std::pmr::vector<std::pmr::vector<std::pmr::vector<int>>> placements_vec(
+      S, resource);
 
   for (int s = 0; s < S; ++s) {
     auto &orients = shape_orients[s];
-    std::vector<uint64_t> pm;
-    std::vector<std::vector<int>> pv;
+    std::pmr::vector<uint64_t> pm(resource);
+    std::pmr::vector<std::pmr::vector<int>> pv(resource);
     pv.reserve(cells);
     pm.reserve(cells);
     for (auto &coords : orients) {
@@ -186,11 +195,11 @@ bool can_pack_region(
             }
             pm.push_back(m);
           } else {
-            std::vector<int> posv;
+            std::pmr::vector<int> posv(resource);
             posv.reserve(coords.size());
             for (auto &c : coords)
               posv.push_back((oy + c.second) * W + (ox + c.first));
-            pv.push_back(posv);
+            pv.push_back(std::move(posv));
           }
         }
     }
@@ -204,10 +213,10 @@ bool can_pack_region(
 
   // build pieces order by placements count (most constrained first)
   int N = (int)piece_list.size();
-  std::vector<int> idxs(N);
+  std::pmr::vector<int> idxs(N, resource);
   for (int i = 0; i < N; ++i)
     idxs[i] = i;
-  std::vector<int> shape_for_piece(N);
+  std::pmr::vector<int> shape_for_piece(N, resource);
   for (int i = 0; i < N; ++i)
     shape_for_piece[i] = piece_list[i];
   std::sort(idxs.begin(), idxs.end(), [&](int a, int b) {
@@ -218,13 +227,15 @@ bool can_pack_region(
                       : (int)placements_vec[sb].size();
     return ca < cb; // ascending (fewest options first)
   });
-  std::vector<int> order(N);
+  std::pmr::vector<int> order(N, resource);
   for (int i = 0; i < N; ++i)
     order[i] = shape_for_piece[idxs[i]];
 
   if (use_mask) {
     uint64_t used = 0;
-    std::function<bool(int)> dfs = [&](int pos) -> bool {
+    // Recursive generic lambda rather than std::function, whose large
+    // capture would be heap allocated for every region
+    auto dfs = [&](auto &self, int pos) -> bool {
       if (pos == N)
         return true;
       int s = order[pos];
@@ -232,17 +243,17 @@ bool can_pack_region(
       for (auto m : cand) {
         if ((m & used) == 0) {
           used |= m;
-          if (dfs(pos + 1))
+          if (self(self, pos + 1))
             return true;
           used ^= m;
         }
       }
       return false;
     };
-    return dfs(0);
+    return dfs(dfs, 0);
   } else {
-    std::vector<char> used(cells, 0);
-    std::function<bool(int)> dfs = [&](int pos) -> bool {
+    std::pmr::vector<char> used(cells, 0, resource);
+    auto dfs = [&](auto &self, int pos) -> bool {
       if (pos == N)
         return true;
       int s = order[pos];
@@ -258,36 +269,56 @@ bool can_pack_region(
           continue;
         for (int p : pv)
           used[p] = 1;
-        if (dfs(pos + 1))
+        if (self(self, pos + 1))
           return true;
         for (int p : pv)
           used[p] = 0;
       }
       return false;
     };
-    return dfs(0);
+    return dfs(dfs, 0);
   }
 }
-} // namespace
 
-int main(int argc, char **argv) {
-  const std::filesystem::path input_file{(argc > 1) ? argv[1]
-                                                    : "../Day12/input"};
+// Shapes as drawn and the regions to pack, the whole parsed input
+struct Puzzle {
+  std::vector<std::vector<std::string>> shapes;
+  std::pmr::vector<Region> regions;
+};
+
+// Cache layout: the rows of every shape joined with '\n' in one character
+// array, and the counts of every region in one int array
+struct ShapeRecord {
+  uint32_t offset;
+  uint32_t size;
+};
+
+struct RegionRecord {
+  int32_t width;
+  int32_t height;
+  uint32_t first_count;
+  uint32_t counts;
+};
+
+std::expected<Puzzle, bool> read_puzzle(const std::filesystem::path &input,
+                                        std::pmr::memory_resource *resource) {
   namespace pc = puzzles::common;
   // Read whole file into lines
-  auto result = pc::readFileByLine<std::vector<std::string>>(
-      input_file, [](std::string_view line, std::vector<std::string> &acc) {
+  auto result = pc::readFileByLineMapped<pc::ArenaLines>(
+      input,
+      [](std::string_view line, pc::ArenaLines &acc) {
         acc.emplace_back(line);
         return true;
-      });
+      },
+      pc::ArenaLines(resource));
   if (!result) {
-    std::println(stderr, pc::InputFileError);
-    return 2;
+    return std::unexpected(false);
   }
   const auto &lines = *result;
 
   // separate into shape section and region section: find first region line
   // containing 'x' and ':'
+  PUZZLES_TRACE_SCOPE("parse shapes and regions");
   size_t split = 0;
   for (size_t i = 0; i < lines.size(); ++i) {
     auto ln = lines[i];
@@ -299,51 +330,149 @@ int main(int argc, char **argv) {
     }
   }
 
-  // collect shape lines from top until split
-  std::vector<std::string> shape_lines(lines.begin(), lines.begin() + split);
-  std::vector<std::string> region_lines(lines.begin() + split, lines.end());
-
-  auto shapes_grid = parse_shapes(shape_lines);
-  auto regions = parse_regions(region_lines);
-
-  int fit_count = 0;
-  for (auto &r : regions) {
-    int W, H;
-    std::vector<int> counts;
-    std::tie(W, H, counts) = r;
-    // expand shapes into piece list
-    int S = (int)shapes_grid.size();
-    std::vector<int> pieces;
-    int total_cells = 0;
-    for (int s = 0; s < S; ++s) {
-      // count '#' in shape
-      int c = 0;
-      for (auto &row : shapes_grid[s])
-        for (char ch : row)
-          if (ch == '#')
-            ++c;
-      for (int k = 0; k < (int)counts.size() && k <= s; ++k) {
-      } // noop
-      int need = (s < (int)counts.size()) ? counts[s] : 0;
-      for (int i = 0; i < need; ++i) {
-        pieces.push_back(s);
-        total_cells += c;
-      }
+  // shape lines from top until split, region lines after
+  return Puzzle{parse_shapes(Lines(lines).first(split)),
+                parse_regions(Lines(lines).subspan(split), resource)};
+}
+
+void store_puzzle(const Puzzle &puzzle, std::vector<char> &shape_text,
+                  std::vector<ShapeRecord> &shapes,
+                  std::vector<RegionRecord> &regions,
+                  std::vector<int32_t> &counts) {
+  for (const auto &shape : puzzle.shapes) {
+    auto offset = static_cast<uint32_t>(shape_text.size());
+    for (const auto &row : shape) {
+      shape_text.insert(shape_text.end(), row.begin(), row.end());
+      shape_text.push_back('\n');
     }
-    if (total_cells > W * H) { /* impossible */
-      continue;
+    shapes.push_back(
+        {offset, static_cast<uint32_t>(shape_text.size()) - offset});
+  }
+  for (const auto &[W, H, region_counts] : puzzle.regions) {
+    regions.push_back({W, H, static_cast<uint32_t>(counts.size()),
+                       static_cast<uint32_t>(region_counts.size())});
+    counts.insert(counts.end(), region_counts.begin(), region_counts.end());
+  }
+}
+
+std::expected<Puzzle, bool>
+load_puzzle(const puzzles::common::CacheReader &cache,
+            std::pmr::memory_resource *resource) {
+  auto shape_text = cache.section<char>(0);
+  auto shapes = cache.section<ShapeRecord>(1);
+  auto regions = cache.section<RegionRecord>(2);
+  auto counts = cache.section<int32_t>(3);
+  if (!shape_text || !shapes || !regions || !counts) {
+    return std::unexpected(false);
+  }
+
+  Puzzle puzzle{{}, std::pmr::vector<Region>(resource)};
+  for (const auto &shape : *shapes) {
+    if (shape.offset + shape.size > shape_text->size()) {
+      return std::unexpected(false);
+    }
+    std::string_view text(shape_text->data() + shape.offset, shape.size);
+    auto &rows = puzzle.shapes.emplace_back();
+    puzzles::common::forEachLine(text, [&rows](std::string_view row) {
+      rows.emplace_back(row);
+      return true;
+    });
+  }
+  for (const auto &region : *regions) {
+    if (region.first_count + region.counts > counts->size()) {
+      return std::unexpected(false);
     }
+    auto first = counts->begin() + region.first_count;
+    puzzle.regions.emplace_back(
+        region.width, region.height,
+        std::pmr::vector<int>(first, first + region.counts, resource));
+  }
+  return puzzle;
+}
 
-    // precompute orientations for each shape
-    std::vector<std::vector<std::vector<Coord>>> shape_orients;
-    for (auto &g : shapes_grid)
-      shape_orients.push_back(generate_orientations(g));
+int solve(const puzzles::common::SolverContext &ctx) {
+  namespace pc = puzzles::common;
+  // Lines and parsed regions live in the arena. Regions are packed in
+  // parallel; every task recycles its packing scratch through a pool of its
+  // own, since neither the arena nor an unsynchronized pool can be shared.
+  // Placement lists of large regions run to hundreds of KiB, so they are
+  // pooled as well.
+  pc::InputArena arena(ctx.input, 8);
+  std::pmr::pool_options pool_options{};
+  pool_options.largest_required_pool_block = 4 << 20;
 
-    bool ok = can_pack_region(W, H, shape_orients, pieces);
-    if (ok)
-      ++fit_count;
+  // The cache sections only have to live until the store callback returns
+  std::vector<char> shape_text;
+  std::vector<ShapeRecord> shape_records;
+  std::vector<RegionRecord> region_records;
+  std::vector<int32_t> counts;
+  auto result = pc::cachedInput<Puzzle>(
+      "day12", 1, ctx.input,
+      [&arena](const std::filesystem::path &input) {
+        return read_puzzle(input, arena.resource());
+      },
+      [&](const Puzzle &puzzle, pc::CacheWriter &cache) {
+        store_puzzle(puzzle, shape_text, shape_records, region_records,
+                     counts);
+        cache.add(shape_text);
+        cache.add(shape_records);
+        cache.add(region_records);
+        cache.add(counts);
+      },
+      [&arena](const pc::CacheReader &cache) {
+        return load_puzzle(cache, arena.resource());
+      });
+  if (!result) {
+    std::println(stderr, pc::InputFileError);
+    return 2;
   }
+  const auto &shapes_grid = result->shapes;
+  const auto &regions = result->regions;
 
-  std::println("{}", fit_count);
+  // precompute orientations for each shape, they do not depend on the region
+  std::vector<std::vector<std::vector<Coord>>> shape_orients;
+  for (auto &g : shapes_grid)
+    shape_orients.push_back(generate_orientations(g));
+
+  auto pack_regions = [&](size_t first, size_t last) {
+    std::pmr::unsynchronized_pool_resource region_pool(pool_options);
+    int fit_count = 0;
+    for (const auto &[W, H, counts] :
+         std::span(regions).subspan(first, last - first)) {
+      // expand shapes into piece list
+      int S = (int)shapes_grid.size();
+      std::pmr::vector<int> pieces(&region_pool);
+      int total_cells = 0;
+      for (int s = 0; s < S; ++s) {
+        // count '#' in shape
+        int c = 0;
+        for (auto &row : shapes_grid[s])
+          for (char ch : row)
+            if (ch == '#')
+              ++c;
+        int need = (s < (int)counts.size()) ? counts[s] : 0;
+        for (int i = 0; i < need; ++i) {
+          pieces.push_back(s);
+          total_cells += c;
+        }
+      }
+      if (total_cells > W * H) { /* impossible */
+        continue;
+      }
+
+      PUZZLES_TRACE_SCOPE("pack region");
+      bool ok = can_pack_region(W, H, shape_orients, pieces, &region_pool);
+      if (ok)
+        ++fit_count;
+    }
+    return fit_count;
+  };
+  int fit_count = pc::parallel_reduce(size_t{0}, regions.size(), 0,
+                                      pack_regions, std::plus<>{});
+
+  std::println(ctx.out, "{}", fit_count);
   return 0;
 }
+} // namespace
+
+PUZZLES_REGISTER_SOLVER("puzzle12", solve)
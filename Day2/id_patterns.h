@@ -0,0 +1,346 @@
+#pragma once
+
+// Digit pattern predicates of Day 2, shared by the solver and the
+// differential tests, which check the string based variants against the
+// arithmetic ones and the closed form and table sums against the
+// predicates.
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <utility>
+
+namespace puzzles::day2 {
+
+// Simple variant using string conversion
+// Check if a number is invalid (pattern repeated in the two halves)
+inline bool is_invalid(uint64_t id) {
+  std::string s = std::to_string(id);
+  if (s.size() % 2 != 0)
+    return false;
+  size_t half = s.size() / 2;
+  return s.substr(0, half) == s.substr(half);
+}
+
+// 10^0 to 10^19, every power of ten below 2^64
+consteval std::array<uint64_t, 20> make_pow10() {
+  std::array<uint64_t, 20> table{};
+  table[0] = 1;
+  for (size_t i = 1; i < table.size(); ++i) {
+    table[i] = table[i - 1] * 10;
+  }
+  return table;
+}
+
+inline constexpr auto POW10 = make_pow10();
+
+// Digit count of the largest number of each bit width: a number of that
+// width has this many digits or one less
+consteval std::array<int, 65> make_width_digits() {
+  std::array<int, 65> table{};
+  for (int width = 1; width <= 64; ++width) {
+    const uint64_t largest = ~uint64_t{0} >> (64 - width);
+    table[width] = 1;
+    while (table[width] < 20 && largest >= POW10[table[width]]) {
+      ++table[width];
+    }
+  }
+  return table;
+}
+
+inline constexpr auto WIDTH_DIGITS = make_width_digits();
+
+// Number of decimal digits, 1 for 0: a table lookup and one comparison
+constexpr int digit_count(uint64_t id) {
+  id |= 1; // same digits, and 0 counts as 1
+  const int digits = WIDTH_DIGITS[std::bit_width(id)];
+  return digits - (id < POW10[digits - 1]);
+}
+
+// 10..010..01 with a one every `period` places, `digits` places in all: the
+// ID that repeats a block h is h times this. Below 2^64 even for 20 digits,
+// where the IDs themselves may not be.
+constexpr uint64_t repeat_multiplier(int digits, int period) {
+  uint64_t multiplier = 0;
+  for (int i = 0; i < digits / period; ++i) {
+    multiplier = multiplier * POW10[period] + 1;
+  }
+  return multiplier;
+}
+
+// A `Digits` digit ID repeats a `Period` digit block exactly when
+// repeat_multiplier divides it: the quotient is the block, and a leading
+// digit of the ID makes it a full `Period` digits. The divisor is a
+// constant, so the check compiles to a multiply and a compare.
+template <int Digits, int Period>
+constexpr bool repeats_block(uint64_t id) {
+  if constexpr (Period < 1 || Period >= Digits || Digits % Period != 0) {
+    return false;
+  } else {
+    constexpr uint64_t multiplier = repeat_multiplier(Digits, Period);
+    return id % multiplier == 0;
+  }
+}
+
+// Digit pattern checks, instantiated per digit count so that the periods to
+// try are unrolled. The ID must have exactly `Digits` digits.
+struct DoubledKernel {
+  template <int Digits> static constexpr bool check(uint64_t id) {
+    return Digits % 2 == 0 && repeats_block<Digits, Digits / 2>(id);
+  }
+};
+
+struct RepeatedKernel {
+  template <int Digits> static constexpr bool check(uint64_t id) {
+    return [id]<int... Periods>(std::integer_sequence<int, Periods...>) {
+      return (repeats_block<Digits, Periods + 1>(id) || ...);
+    }(std::make_integer_sequence<int, Digits / 2>{});
+  }
+};
+
+// fn.operator()<digits>() for a digit count of 1 to 20, each count its own
+// instantiation
+template <typename Fn> constexpr auto with_digits(int digits, Fn &&fn) {
+  return [&]<int... Digits>(std::integer_sequence<int, Digits...>) {
+    decltype(fn.template operator()<1>()) result{};
+    ((digits == Digits + 1 &&
+      (result = fn.template operator()<Digits + 1>(), true)) ||
+     ...);
+    return result;
+  }(std::make_integer_sequence<int, 20>{});
+}
+
+template <typename Kernel> constexpr bool check_id(uint64_t id) {
+  return with_digits(digit_count(id), [id]<int Digits>() {
+    return Kernel::template check<Digits>(id);
+  });
+}
+
+// Bit i set if first + i passes the kernel. The eight IDs share a digit
+// count unless they cross a power of ten, so the count is found once and
+// the lanes run the same constant division, independent of each other.
+template <typename Kernel> constexpr uint8_t check_ids8(uint64_t first) {
+  const int digits = digit_count(first);
+  if (first > std::numeric_limits<uint64_t>::max() - 7 ||
+      digit_count(first + 7) != digits) {
+    uint8_t mask = 0;
+    for (uint64_t i = 0; i < 8 && first + i >= first; ++i) {
+      mask |= static_cast<uint8_t>(check_id<Kernel>(first + i) << i);
+    }
+    return mask;
+  }
+  return with_digits(digits, [first]<int Digits>() {
+    uint8_t mask = 0;
+    for (uint64_t i = 0; i < 8; ++i) {
+      mask |= static_cast<uint8_t>(Kernel::template check<Digits>(first + i)
+                                   << i);
+    }
+    return mask;
+  });
+}
+
+// Without string conversion
+// Check if a number is valid (no digit repeated in corresponding positions)
+// Example: 1234 is valid, 1212 is invalid (12 repeated), 123123 is invalid
+constexpr bool is_valid(uint64_t id) { return !check_id<DoubledKernel>(id); }
+
+// Sum of the IDs in [first, last] with `digits` digits that repeat a block
+// of `period` digits, `period` dividing `digits`, modulo 2^64 like a sum
+// taken one ID at a time. Such an ID is h * repeat_multiplier for a `period`
+// digit h, so the IDs form an arithmetic series over a range of h: O(1).
+constexpr uint64_t sum_periodic_ids(uint64_t first, uint64_t last, int digits,
+                                    int period) {
+  const uint64_t block_min = POW10[period - 1];
+  const uint64_t multiplier = repeat_multiplier(digits, period);
+  const uint64_t lo =
+      std::max(block_min, first / multiplier + (first % multiplier != 0));
+  const uint64_t hi = std::min(block_min * 10 - 1, last / multiplier);
+  if (lo > hi) {
+    return 0;
+  }
+  // (lo + hi) * count / 2 with the halving on whichever factor is even,
+  // so nothing but the final wrap-around is lost
+  uint64_t pair_sum = lo + hi;
+  uint64_t count = hi - lo + 1;
+  (pair_sum % 2 == 0 ? pair_sum : count) /= 2;
+  return multiplier * pair_sum * count;
+}
+
+// Sum of the IDs in [first, last] that are one half repeated: one series
+// per even digit length, up to 20 digits
+constexpr uint64_t sum_doubled_ids(uint64_t first, uint64_t last) {
+  uint64_t sum = 0;
+  for (int k = 1; k <= 10; ++k) {
+    sum += sum_periodic_ids(first, last, 2 * k, k);
+  }
+  return sum;
+}
+
+// The distinct primes dividing a digit count; lengths up to 20 have at most
+// two. An ID repeating blocks of lengths a and b repeats one of gcd(a, b),
+// so every ID repeating a shorter block repeats one of digits / q for such
+// a prime q.
+struct LengthPrimes {
+  std::array<int, 2> primes{};
+  size_t count = 0;
+};
+
+constexpr LengthPrimes length_primes(int digits) {
+  LengthPrimes found;
+  for (int q : {2, 3, 5, 7, 11, 13, 17, 19}) {
+    if (digits % q == 0) {
+      found.primes[found.count++] = q;
+    }
+  }
+  return found;
+}
+
+// Sum of the IDs in [first, last] with `min_digits` to 20 digits that repeat
+// a shorter block at least twice, by inclusion-exclusion over the periods
+// digits / q so that every such ID counts once
+constexpr uint64_t sum_repeated_ids_closed_form(uint64_t first, uint64_t last,
+                                                int min_digits = 1) {
+  uint64_t sum = 0;
+  for (int digits = std::max(min_digits, 2); digits <= 20; ++digits) {
+    const auto [primes, count] = length_primes(digits);
+    for (size_t i = 0; i < count; ++i) {
+      sum += sum_periodic_ids(first, last, digits, digits / primes[i]);
+    }
+    if (count == 2) {
+      sum -= sum_periodic_ids(first, last, digits,
+                              digits / (primes[0] * primes[1]));
+    }
+  }
+  return sum;
+}
+
+// Every ID of up to REPEATED_TABLE_DIGITS digits that repeats a shorter block
+// at least twice, 101088 of them, built while compiling. Longer ones number
+// in the billions, so sum_repeated_ids covers those with the closed form
+// instead.
+constexpr int REPEATED_TABLE_DIGITS = 10;
+
+// Same inclusion-exclusion as the closed form, counting instead of summing
+consteval size_t count_repeated_ids(int max_digits) {
+  size_t count = 0;
+  for (int digits = 2; digits <= max_digits; ++digits) {
+    const auto [primes, factors] = length_primes(digits);
+    for (size_t i = 0; i < factors; ++i) {
+      count += 9 * POW10[digits / primes[i] - 1];
+    }
+    if (factors == 2) {
+      count -= 9 * POW10[digits / (primes[0] * primes[1]) - 1];
+    }
+  }
+  return count;
+}
+
+constexpr size_t REPEATED_TABLE_SIZE =
+    count_repeated_ids(REPEATED_TABLE_DIGITS);
+
+struct RepeatedIdTable {
+  std::array<uint64_t, REPEATED_TABLE_SIZE> ids{}; // sorted, each once
+  std::array<uint64_t, REPEATED_TABLE_SIZE + 1> prefix{}; // sums of ids[0, i)
+
+  // Sum of the table IDs in [first, last]: two binary searches
+  constexpr uint64_t sum(uint64_t first, uint64_t last) const {
+    auto lo = std::ranges::lower_bound(ids, first) - ids.begin();
+    auto hi = std::ranges::upper_bound(ids, last) - ids.begin();
+    return lo < hi ? prefix[hi] - prefix[lo] : 0;
+  }
+};
+
+// The IDs of one length and period are block_min * M, (block_min + 1) * M,
+// ... for M = repeat_multiplier, an arithmetic series, so the IDs of a
+// length come out sorted by merging the series of its at most two periods
+// digits / q; multi-period IDs like 111111 are in both and taken once. No
+// sort, which keeps the constant evaluation to about a second.
+consteval RepeatedIdTable make_repeated_id_table() {
+  RepeatedIdTable table;
+  uint64_t *id = table.ids.data();
+  uint64_t *sum = table.prefix.data();
+  for (int digits = 2; digits <= REPEATED_TABLE_DIGITS; ++digits) {
+    const auto [primes, count] = length_primes(digits);
+    // Series of the first period, and of the second if there is one
+    const uint64_t step = repeat_multiplier(digits, digits / primes[0]);
+    uint64_t next = POW10[digits / primes[0] - 1] * step;
+    const uint64_t end = POW10[digits / primes[0]] * step;
+    uint64_t other_step = 0;
+    uint64_t other = end;
+    uint64_t other_end = end;
+    if (count == 2) {
+      other_step = repeat_multiplier(digits, digits / primes[1]);
+      other = POW10[digits / primes[1] - 1] * other_step;
+      other_end = POW10[digits / primes[1]] * other_step;
+    }
+    while (next != end || other != other_end) {
+      const bool take_next =
+          next != end && (other == other_end || next <= other);
+      const uint64_t value = take_next ? next : other;
+      if (take_next) {
+        next += step;
+      }
+      if (other == value) {
+        other += other_step;
+      }
+      *id++ = value;
+      sum[1] = sum[0] + value;
+      ++sum;
+    }
+  }
+  return table;
+}
+
+inline constexpr RepeatedIdTable REPEATED_ID_TABLE = make_repeated_id_table();
+// Filled to the end, so the count and the merge agree
+static_assert(REPEATED_ID_TABLE.ids.back() == POW10[REPEATED_TABLE_DIGITS] - 1);
+
+// Sum of the IDs in [first, last] that repeat a shorter block at least
+// twice, the same as summing is_invalid2 over the range
+constexpr uint64_t sum_repeated_ids(uint64_t first, uint64_t last) {
+  return REPEATED_ID_TABLE.sum(first, last) +
+         sum_repeated_ids_closed_form(first, last, REPEATED_TABLE_DIGITS + 1);
+}
+
+// Simple variant using string conversion
+// Check if a number is invalid (pattern repeated at least twice)
+inline bool is_invalid2_string(uint64_t id) {
+  std::string s = std::to_string(id);
+  size_t len = s.size();
+
+  // Try all possible pattern lengths from 1 to len/2
+  for (size_t pattern_len = 1; pattern_len <= len / 2; ++pattern_len) {
+    // Check if the length is divisible by pattern_len
+    if (len % pattern_len != 0)
+      continue;
+
+    // Extract the pattern
+    std::string pattern = s.substr(0, pattern_len);
+
+    // Check if the entire string is made of this pattern repeated
+    bool is_repeated = true;
+    for (size_t i = pattern_len; i < len; i += pattern_len) {
+      if (s.substr(i, pattern_len) != pattern) {
+        is_repeated = false;
+        break;
+      }
+    }
+
+    if (is_repeated) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+// Without string conversion
+// Check if a number is invalid (pattern repeated at least twice)
+constexpr bool is_invalid2(uint64_t id) {
+  return check_id<RepeatedKernel>(id);
+}
+
+} // namespace puzzles::day2
@@ -7,104 +7,116 @@
  */
 
 #include "../common/common.h"
+#include "../common/registry.h"
+#include "../common/thread_pool.h"
+#include "id_patterns.h"
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <functional>
+#include <iterator>
 #include <iostream>
 #include <print>
-#include <regex>
-
-// Simple variant using string conversion
-// Check if a number is invalid (pattern repeated in the two halves)
-bool is_invalid(uint64_t id) {
-  std::string s = std::to_string(id);
-  if (s.size() % 2 != 0)
-    return false;
-  size_t half = s.size() / 2;
-  return s.substr(0, half) == s.substr(half);
-}
-
-// Without string conversion
-// Check if a number is valid (no digit repeated in corresponding positions)
-// Example: 1234 is valid, 1212 is invalid (12 repeated), 123123 is invalid
-// TODO: Try to optimize with constevaluation and folding
-constexpr auto DIGITS_STEP = 100;
-constexpr auto DIVID_STEP = 10;
-
-bool is_valid(uint64_t id, uint64_t max = DIGITS_STEP,
-              uint64_t min = DIVID_STEP, uint64_t divider = DIVID_STEP) {
-  if (divider > max)
-    return true;
-  if (id < max && id >= min)
-    return id / divider != id % divider;
-  return is_valid(id, max * DIGITS_STEP, min * DIGITS_STEP,
-                  divider * DIVID_STEP);
-}
-
-// Check if a number is invalid (pattern repeated at least twice)
-bool is_invalid2(uint64_t id) {
-  std::string s = std::to_string(id);
-  size_t len = s.size();
-
-  // Try all possible pattern lengths from 1 to len/2
-  for (size_t pattern_len = 1; pattern_len <= len / 2; ++pattern_len) {
-    // Check if the length is divisible by pattern_len
-    if (len % pattern_len != 0)
-      continue;
-
-    // Extract the pattern
-    std::string pattern = s.substr(0, pattern_len);
-
-    // Check if the entire string is made of this pattern repeated
-    bool is_repeated = true;
-    for (size_t i = pattern_len; i < len; i += pattern_len) {
-      if (s.substr(i, pattern_len) != pattern) {
-        is_repeated = false;
-        break;
+#include <string_view>
+#include <vector>
+
+namespace {
+using puzzles::day2::check_id;
+using puzzles::day2::check_ids8;
+using puzzles::day2::DoubledKernel;
+using puzzles::day2::is_invalid;
+using puzzles::day2::is_invalid2_string;
+using puzzles::day2::RepeatedKernel;
+using puzzles::day2::sum_doubled_ids;
+using puzzles::day2::sum_repeated_ids;
+
+using Range = std::array<uint64_t, 2>;
+
+// Brute-force engines, each summing the IDs in [first, last) that match:
+// one ID at a time with any predicate, or eight at a time with a digit
+// kernel. `matches` checks a single ID.
+template <bool (*Matches)(uint64_t)> struct EachId {
+  static uint64_t scan(uint64_t first, uint64_t last) {
+    PUZZLES_TRACE_SCOPE("scan range");
+    uint64_t sum = 0;
+    for (auto id = first; id < last; ++id) {
+      sum += Matches(id) ? id : 0;
+    }
+    return sum;
+  }
+  static bool matches(uint64_t id) { return Matches(id); }
+};
+
+template <typename Kernel> struct EightIds {
+  static uint64_t scan(uint64_t first, uint64_t last) {
+    PUZZLES_TRACE_SCOPE("scan range");
+    uint64_t sum = 0;
+    auto id = first;
+    for (; last - id >= 8; id += 8) {
+      for (auto mask = check_ids8<Kernel>(id); mask != 0; mask &= mask - 1) {
+        sum += id + std::countr_zero(mask);
       }
     }
-
-    if (is_repeated) {
-      return true;
+    for (; id < last; ++id) {
+      sum += check_id<Kernel>(id) ? id : 0;
     }
+    return sum;
   }
-
-  return false;
+  static bool matches(uint64_t id) { return check_id<Kernel>(id); }
+};
+
+// Sum of the IDs in [first, last] the engine matches. Every ID is checked on
+// its own, so the range is split across threads; the chunks are half open,
+// and last + 1 wraps for UINT64_MAX, so last is checked separately.
+template <typename Engine> uint64_t scan_range(uint64_t first, uint64_t last) {
+  return puzzles::common::parallel_reduce(first, last, uint64_t{0},
+                                          Engine::scan,
+                                          std::plus<uint64_t>{}) +
+         (Engine::matches(last) ? last : 0);
 }
 
-int main(int argc, char *argv[]) {
+// Selected with --scan <name>, to time the predicates against each other
+struct ScanEngine {
+  std::string_view name;
+  uint64_t (*doubled)(uint64_t first, uint64_t last);
+  uint64_t (*repeated)(uint64_t first, uint64_t last);
+};
 
-  namespace pc = puzzles::common;
+constexpr std::array<ScanEngine, 3> ScanEngines{{
+    {"string", scan_range<EachId<is_invalid>>,
+     scan_range<EachId<is_invalid2_string>>},
+    {"kernel", scan_range<EachId<check_id<DoubledKernel>>>,
+     scan_range<EachId<check_id<RepeatedKernel>>>},
+    {"kernel8", scan_range<EightIds<DoubledKernel>>,
+     scan_range<EightIds<RepeatedKernel>>},
+}};
+
+int solve(const puzzles::common::SolverContext &ctx) {
 
-  const std::filesystem::path input_file =
-      (argc > 1) ? argv[1] : "../Day2/input";
+  namespace pc = puzzles::common;
 
-  using ResultType = std::tuple<uint64_t, uint64_t>;
+  using ResultType = std::vector<Range>;
   auto result = pc::readFileByLine<ResultType>(
-      input_file, [](std::string_view line, ResultType &accum) -> bool {
-        std::regex pattern(R"((\s*\d+\s*)-(\s*\d+\s*))");
-        auto it = std::cregex_iterator(&line.data()[0],
-                                       &line.data()[0] + line.size(), pattern);
-        auto end = std::cregex_iterator();
-        if (it == end) {
-          return false;
-        }
-        for (; it != end; ++it) {
-          auto &match = *it;
-
-          auto first = pc::to_unsigned<uint64_t>(match[1].str());
-          auto last = pc::to_unsigned<uint64_t>(match[2].str());
-          if (first && last) {
-            for (auto id = *first; id <= *last; ++id) {
-              if (!is_valid(id)) {
-                std::get<0>(accum) += id;
-              }
-              if (is_invalid2(id)) {
-                std::get<1>(accum) += id;
-              }
-            }
-          } else {
+      ctx.input, [](std::string_view line, ResultType &accum) -> bool {
+        // Comma separated "first-last" ranges
+        size_t ranges = 0;
+        for (size_t pos = 0; pos < line.size();) {
+          size_t comma = std::min(line.find(',', pos), line.size());
+          auto range = line.substr(pos, comma - pos);
+          pos = comma + 1;
+          if (pc::find_digit(range) == std::string_view::npos) {
+            continue;
+          }
+
+          Range bounds{};
+          auto fields = pc::parse_integers(range, std::span(bounds));
+          if (!fields || *fields != bounds.size()) {
             return false;
           }
+          accum.push_back(bounds);
+          ++ranges;
         }
-        return true;
+        return ranges > 0;
       });
 
   if (!result) {
@@ -112,6 +124,51 @@ int main(int argc, char *argv[]) {
     return 1;
   }
 
-  std::println("{} {}", std::get<0>(*result), std::get<1>(*result));
+  // Part 1 is summed in closed form and part 2 from the table of repeated
+  // IDs; with --verify every ID is checked by the kernels as well, and with
+  // --scan <engine> the answers come from checking every ID instead
+  const bool verify =
+      std::ranges::find(ctx.args, "--verify") != ctx.args.end();
+  const ScanEngine *scan = nullptr;
+  auto scan_arg = std::ranges::find(ctx.args, "--scan");
+  if (scan_arg != ctx.args.end()) {
+    const auto name = std::next(scan_arg) != ctx.args.end()
+                          ? *std::next(scan_arg)
+                          : std::string_view{};
+    auto engine = std::ranges::find(ScanEngines, name, &ScanEngine::name);
+    if (engine == ScanEngines.end()) {
+      std::println(stderr, "Expected --scan string|kernel|kernel8");
+      return 1;
+    }
+    scan = &*engine;
+  }
+
+  uint64_t doubled = 0;
+  uint64_t repeated = 0;
+  for (const auto &[first, last] : *result) {
+    if (first > last) {
+      continue;
+    }
+    if (scan) {
+      doubled += scan->doubled(first, last);
+      repeated += scan->repeated(first, last);
+      continue;
+    }
+    const uint64_t doubled_sum = sum_doubled_ids(first, last);
+    const uint64_t repeated_sum = sum_repeated_ids(first, last);
+    if (verify &&
+        (doubled_sum != ScanEngines.back().doubled(first, last) ||
+         repeated_sum != ScanEngines.back().repeated(first, last))) {
+      std::println(stderr, "Sums of {}-{} differ from the scan", first, last);
+      return 1;
+    }
+    doubled += doubled_sum;
+    repeated += repeated_sum;
+  }
+
+  std::println(ctx.out, "{} {}", doubled, repeated);
   return 0;
 }
+} // namespace
+
+PUZZLES_REGISTER_SOLVER("puzzle2", solve)
@@ -6,12 +6,24 @@
  * Expected output: 16858 167549941654721
  */
 #include "../common/common.h"
+#include "../common/embed.h"
+#include "../common/incremental.h"
+#include "../common/registry.h"
+#include "../common/stream.h"
+#include <algorithm>
+#include <array>
+#include <expected>
+#include <filesystem>
 #include <iostream>
 #include <print>
+#include <span>
 #include <string>
+#include <vector>
 
+namespace {
 using MaxPositionData = std::tuple<int, int>;
-MaxPositionData get_max_from(int pos, std::string_view bank, size_t max) {
+constexpr MaxPositionData get_max_from(int pos, std::string_view bank,
+                                       size_t max) {
   int max_val = 0;
   size_t max_pos = pos;
   for (size_t i = pos; i < max; ++i) {
@@ -26,7 +38,9 @@ MaxPositionData get_max_from(int pos, std::string_view bank, size_t max) {
   return std::make_tuple(max_val, max_pos);
 }
 
-uint64_t get_max_joltage(std::string_view bank, int max_digits = 12) {
+constexpr uint64_t get_max_joltage(std::string_view bank, int max_digits = 12) {
+  // A bank shorter than that, like a line still being appended, uses them all
+  max_digits = std::min(max_digits, static_cast<int>(bank.size()));
   uint64_t max_joltage = 0;
   MaxPositionData max_pos = std::make_tuple(0, 0);
   for (int i = max_digits - 1; i >= 0; --i) {
@@ -37,25 +51,90 @@ uint64_t get_max_joltage(std::string_view bank, int max_digits = 12) {
   return max_joltage;
 }
 
-int main(int argc, char *argv[]) {
-  namespace pc = puzzles::common;
+namespace pc = puzzles::common;
+// Sums with 2 and with 12 digits per bank
+using ResultType = std::array<uint64_t, 2>;
 
-  const std::filesystem::path input_file =
-      (argc > 1) ? argv[1] : "../Day3/input";
+// Adds the banks of `text`, one per line, to the sums
+constexpr bool addBanks(std::string_view text, ResultType &accum) {
+  return pc::forEachLine(text, [&accum](std::string_view bank) {
+    std::get<0>(accum) += get_max_joltage(bank, 2);
+    std::get<1>(accum) += get_max_joltage(bank, 12);
+    return true;
+  });
+}
 
-  using ResultType = std::tuple<uint64_t, uint64_t>;
+// Whole puzzle over text already in memory, one bank per line
+constexpr ResultType solveText(std::string_view text) {
+  ResultType accum{};
+  addBanks(text, accum);
+  return accum;
+}
 
-  auto result = pc::readFileByLine<ResultType>(
-      input_file, [](std::string_view line, ResultType &accum) -> bool {
-        std::get<0>(accum) += get_max_joltage(line, 2);
-        std::get<1>(accum) += get_max_joltage(line, 12);
+// Banks are independent: they are solved on worker threads while the
+// rest of the input is still being read. The banks are views of the
+// read-ahead buffer, which lives until their batch is done.
+std::expected<ResultType, bool> readBanks(const std::filesystem::path &input) {
+  return pc::readFilePipelined<std::string_view, ResultType>(
+      input,
+      [](std::string_view line, std::vector<std::string_view> &banks) {
+        banks.push_back(line);
+        return true;
+      },
+      [](std::span<const std::string_view> banks, ResultType &accum) {
+        for (auto bank : banks) {
+          std::get<0>(accum) += get_max_joltage(bank, 2);
+          std::get<1>(accum) += get_max_joltage(bank, 12);
+        }
         return true;
+      },
+      [](ResultType &total, ResultType &&part) {
+        std::get<0>(total) += std::get<0>(part);
+        std::get<1>(total) += std::get<1>(part);
+      },
+      pc::PipelineOptions{.batch_records = 16});
+}
+
+// Sums of the previous run over this file plus the banks appended since
+std::expected<ResultType, bool>
+resumeBanks(const std::filesystem::path &input) {
+  return pc::incrementalInput<ResultType>(
+      "day3", 1, input, addBanks,
+      [](const ResultType &accum, pc::CacheWriter &state) {
+        state.add(std::span<const uint64_t>(accum));
+      },
+      [](const pc::CacheReader &state) -> std::expected<ResultType, bool> {
+        auto sums = state.section<uint64_t>(0);
+        if (!sums || sums->size() != ResultType{}.size()) {
+          return std::unexpected(false);
+        }
+        ResultType accum{};
+        std::ranges::copy(*sums, accum.begin());
+        return accum;
       });
+}
+
+int solve(const pc::SolverContext &ctx) {
+#ifdef PUZZLES_HAS_EMBEDDED_INPUT
+  if (ctx.input == PUZZLES_DEFAULT_INPUT) {
+    static constexpr auto answer = solveText(pc::embeddedInput());
+    std::println(ctx.out, "{} {}", std::get<0>(answer), std::get<1>(answer));
+    return 0;
+  }
+#endif
+
+  // With $PUZZLES_STATE_DIR set only banks appended since the last run over
+  // the file are solved
+  auto result = pc::incrementalMode(ctx.input) ? resumeBanks(ctx.input)
+                                               : readBanks(ctx.input);
 
   if (!result) {
     std::println(stderr, pc::InputFileError);
     return 1;
   }
-  std::println("{} {}", std::get<0>(*result), std::get<1>(*result));
+  std::println(ctx.out, "{} {}", std::get<0>(*result), std::get<1>(*result));
   return 0;
 }
+} // namespace
+
+PUZZLES_REGISTER_SOLVER("puzzle3", solve)
@@ -6,83 +6,73 @@
  * based on adjacent roll counts.
  * Expected output: 1411 8557
  */
-#include "../common/common.h"
+#include "../common/grid.h"
+#include "../common/registry.h"
+#include <array>
 #include <iostream>
 #include <print>
-#include <string>
+#include <span>
 #include <vector>
 
 namespace {
 constexpr auto CalculationError = "Error calculating accessible rolls.";
-}
+// Rows and columns per cache block of the neighbour sweep
+constexpr int TileSize = 64;
 
-int main(int argc, char *argv[]) {
+int solve(const puzzles::common::SolverContext &ctx) {
   namespace pc = puzzles::common;
-  const std::filesystem::path input_file =
-      (argc > 1) ? argv[1] : "../Day4/input";
-
-  auto result = pc::readFileByLine<std::vector<std::string>>(
-      input_file,
-      [](std::string_view line, std::vector<std::string> &accumulate) {
-        accumulate.push_back(std::string(line));
-        return true;
-      });
+  // Grid and the removal lists of every round
+  pc::InputArena arena(ctx.input, 16);
+  using Grid = pc::ArenaGrid<char>;
+  // One ring of empty cells around the rolls, so every cell has 8 neighbours
+  auto result = pc::readGrid(ctx.input, 1, '.',
+                             Grid::allocator_type(arena.resource()));
 
   if (!result) {
     std::println(stderr, pc::InputFileError);
     return 1;
   }
+  Grid &grid = *result;
 
-  using RemoveList = std::vector<std::pair<int, int>>;
-  auto calculate_accessible = [=](const std::vector<std::string> &grid)
-      -> std::expected<RemoveList, bool> {
-    int rows = grid.size();
-    if (rows == 0) {
+  using RemoveList = std::pmr::vector<std::pair<int, int>>;
+  auto calculate_accessible =
+      [resource = arena.resource()](
+          const Grid &grid) -> std::expected<RemoveList, bool> {
+    PUZZLES_TRACE_SCOPE("find accessible");
+    if (grid.rows() == 0) {
       std::println(stderr, "Empty grid.");
       return std::unexpected(false);
     }
-    int cols = grid[0].size();
-
-    auto check_accessible = [=](int x, int y) -> bool {
-      return x >= 0 && x < rows && y >= 0 && y < cols && grid[x][y] == '@';
-    };
 
-    RemoveList to_remove{};
-    // Direction vectors for 8 adjacent positions
-    const int dx[] = {-1, -1, -1, 0, 0, 1, 1, 1};
-    const int dy[] = {-1, 0, 1, -1, 1, -1, 0, 1};
-
-    for (int i = 0; i < rows; ++i) {
-      for (int j = 0; j < cols; ++j) {
-        if (grid[i][j] == '@') {
-          // Count adjacent rolls
-          int adjacent_rolls = 0;
-          for (int d = 0; d < 8; ++d) {
-            if (check_accessible(i + dx[d], j + dy[d])) {
-              adjacent_rolls++;
-            }
-          }
-          // A roll can be accessed if there are fewer than 4 adjacent rolls
-          if (adjacent_rolls < 4) {
-            to_remove.push_back({i, j});
-          }
+    RemoveList to_remove(resource);
+    std::array<int, TileSize> columns;
+    for (const auto tile : grid.tiles(TileSize, TileSize)) {
+      for (int i = tile.row; i < tile.row + tile.rows; ++i) {
+        // The border makes column -1 and cols valid in all three rows.
+        // A roll can be accessed if there are fewer than 4 adjacent rolls.
+        size_t found = pc::sparse_cells(
+            &grid(i - 1, 0), &grid(i, 0), &grid(i + 1, 0), tile.col,
+            tile.col + tile.cols, '@', 4, columns.data());
+        for (int j : std::span(columns).first(found)) {
+          to_remove.push_back({i, j});
         }
       }
     }
     return to_remove;
   };
 
-  auto to_remove_result = calculate_accessible(*result);
+  auto to_remove_result = calculate_accessible(grid);
   if (!to_remove_result) {
     std::println(stderr, CalculationError);
     return 1;
   }
   int total_accessed = (*to_remove_result).size();
 
-  auto grid_copy = *result;
+  // Part 1 is done with the grid, so the removal rounds work on it in place
+  PUZZLES_TRACE_SCOPE("remove rolls");
   int total_removed = 0;
   while (true) {
-    auto to_remove_result = calculate_accessible(grid_copy);
+    auto to_remove_result = calculate_accessible(grid);
     if (!to_remove_result) {
       std::println(stderr, CalculationError);
       return 1;
@@ -91,13 +81,16 @@ int main(int argc, char *argv[]) {
     if (!to_remove_result->empty()) {
       total_removed += to_remove_result->size();
       for (const auto &pos : *to_remove_result) {
-        grid_copy[pos.first][pos.second] = '.';
+        grid(pos.first, pos.second) = '.';
       }
     } else {
       break; // No more accessible rolls to remove
     }
   }
 
-  std::println("{} {}", total_accessed, total_removed);
+  std::println(ctx.out, "{} {}", total_accessed, total_removed);
   return 0;
 }
+} // namespace
+
+PUZZLES_REGISTER_SOLVER("puzzle4", solve)
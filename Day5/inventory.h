@@ -0,0 +1,160 @@
+#pragma once
+
+// Input of Day 5: fresh ID ranges, a blank line, then the available IDs one
+// per line. Shared by the solver and the differential tests, which check the
+// batch reader against reading one line at a time.
+
+#include "../common/common.h"
+#include <algorithm>
+#include <expected>
+#include <filesystem>
+#include <format>
+#include <print>
+#include <span>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+namespace puzzles::day5 {
+struct Range {
+  uint64_t start;
+  uint64_t end;
+
+  constexpr bool contains(uint64_t id) const {
+    return id >= start && id <= end;
+  }
+
+  // Check if ranges are completely separated (have a gap)
+  constexpr bool rangesAreSeparated(const Range &other) const {
+    return end + 1 < other.start || other.end + 1 < start;
+  }
+
+  // Check if this range overlaps or is adjacent to another range
+  constexpr bool overlapsOrAdjacent(const Range &other) const {
+    return !rangesAreSeparated(other);
+  }
+
+  // Merge this range with another overlapping range
+  constexpr Range merge(const Range &other) const {
+    return {std::min(start, other.start), std::max(end, other.end)};
+  }
+
+  // Count of IDs in this range
+  constexpr uint64_t count() const { return end - start + 1; }
+
+  // For sorting
+  auto operator<=>(const Range &other) const = default;
+};
+
+enum class RangeError { Empty, Format, Number, Order };
+
+constexpr std::expected<Range, RangeError> parseRange(std::string_view line) {
+  if (line.empty()) {
+    return std::unexpected(RangeError::Empty);
+  }
+  auto dash_pos = line.find('-');
+  if (dash_pos == std::string::npos) {
+    return std::unexpected(RangeError::Format);
+  }
+
+  auto start = common::to_unsigned<uint64_t>(line.substr(0, dash_pos));
+  auto end = common::to_unsigned<uint64_t>(line.substr(dash_pos + 1));
+
+  if (!start || !end) {
+    return std::unexpected(RangeError::Number);
+  }
+
+  if (*start > *end) {
+    return std::unexpected(RangeError::Order);
+  }
+  return Range{*start, *end};
+}
+
+inline std::expected<Range, std::string> parseLine(std::string_view line) {
+  auto range = parseRange(line);
+  if (range) {
+    return *range;
+  }
+  switch (range.error()) {
+  case RangeError::Empty:
+    return std::unexpected("Empty line");
+  case RangeError::Format:
+    return std::unexpected(std::format("Invalid range format: {}", line));
+  case RangeError::Number:
+    return std::unexpected(std::format("Error parsing range: {}", line));
+  case RangeError::Order:
+    break;
+  }
+  return std::unexpected(std::format("Invalid range (start > end): {}", line));
+}
+
+// Fresh ranges and available IDs, the two sections of the input
+struct Inventory {
+  std::vector<Range> ranges;
+  std::vector<uint64_t> ids;
+};
+
+// Reads both sections, the IDs batch_lines at a time
+inline std::expected<Inventory, bool>
+readInventory(const std::filesystem::path &input,
+              size_t batch_lines = common::DefaultBatchLines) {
+  using RangesType = std::vector<Range>;
+  using IDsType = std::vector<uint64_t>;
+
+  IDsType available_ids{};
+
+  enum class ReadState { Ranges, IDs };
+  ReadState state = ReadState::Ranges;
+
+  auto result = common::readFileByBatch<RangesType>(
+      input,
+      [&available_ids, &state](std::span<const std::string_view> lines,
+                               RangesType &accumulate) {
+        for (size_t i = 0; i < lines.size(); ++i) {
+          if (state == ReadState::IDs) {
+            // Rest of the batch is one ID per line; blank lines are skipped
+            // like the line by line readers do, and every run of IDs between
+            // them is converted in one pass
+            auto rest = lines.subspan(i);
+            while (!rest.empty()) {
+              auto blank = std::ranges::find_if(
+                  rest, [](std::string_view line) { return line.empty(); });
+              const auto ids =
+                  rest.first(static_cast<size_t>(blank - rest.begin()));
+              rest = rest.subspan(ids.size() + (blank != rest.end()));
+              size_t offset = available_ids.size();
+              available_ids.resize(offset + ids.size());
+              auto converted = common::to_unsigned_many(
+                  ids, std::span(available_ids).subspan(offset));
+              if (!converted) {
+                std::println(stderr, "Error parsing IDs: {}",
+                             std::make_error_code(converted.error()).message());
+                return false;
+              }
+            }
+            return true;
+          }
+          if (lines[i].empty()) {
+            // Switch to reading available IDs
+            state = ReadState::IDs;
+            continue;
+          }
+          auto parse_result = parseLine(lines[i]);
+          if (!parse_result) {
+            std::println(stderr, "Error: {}", parse_result.error());
+            return false;
+          }
+          accumulate.push_back(*parse_result);
+        }
+        return true;
+      },
+      batch_lines);
+
+  if (!result) {
+    return std::unexpected(false);
+  }
+  return Inventory{std::move(*result), std::move(available_ids)};
+}
+
+} // namespace puzzles::day5
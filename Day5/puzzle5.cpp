@@ -6,69 +6,33 @@
  * and the total count of fresh ingredient IDs after merging overlapping ranges.
  * Expected output: 529 344260049617193
  */
+#include "../common/cache.h"
 #include "../common/common.h"
+#include "../common/embed.h"
+#include "../common/incremental.h"
+#include "../common/registry.h"
+#include "inventory.h"
 #include <algorithm>
 #include <expected>
+#include <filesystem>
+#include <optional>
 #include <print>
 #include <ranges>
+#include <span>
 #include <string>
 #include <string_view>
+#include <utility>
 #include <vector>
 
+namespace {
 namespace pc = puzzles::common;
-struct Range {
-  uint64_t start;
-  uint64_t end;
+using puzzles::day5::Inventory;
+using puzzles::day5::parseLine;
+using puzzles::day5::parseRange;
+using puzzles::day5::Range;
+using puzzles::day5::readInventory;
 
-  bool contains(uint64_t id) const { return id >= start && id <= end; }
-
-  // Check if ranges are completely separated (have a gap)
-  bool rangesAreSeparated(const Range &other) const {
-    return end + 1 < other.start || other.end + 1 < start;
-  }
-
-  // Check if this range overlaps or is adjacent to another range
-  bool overlapsOrAdjacent(const Range &other) const {
-    return !rangesAreSeparated(other);
-  }
-
-  // Merge this range with another overlapping range
-  Range merge(const Range &other) const {
-    return {std::min(start, other.start), std::max(end, other.end)};
-  }
-
-  // Count of IDs in this range
-  uint64_t count() const { return end - start + 1; }
-
-  // For sorting
-  auto operator<=>(const Range &other) const = default;
-};
-
-std::expected<Range, std::string_view> parseLine(std::string_view line) {
-
-  if (line.empty()) {
-    return std::unexpected("Empty line");
-  }
-  auto dash_pos = line.find('-');
-  if (dash_pos == std::string::npos) {
-    return std::unexpected(std::format("Invalid range format: {}", line));
-  }
-
-  auto start = pc::to_unsigned<uint64_t>(line.substr(0, dash_pos));
-  auto end = pc::to_unsigned<uint64_t>(line.substr(dash_pos + 1));
-
-  if (!start || !end) {
-    return std::unexpected(std::format("Error parsing range: {}", line));
-  }
-
-  if (*start > *end) {
-    return std::unexpected(
-        std::format("Invalid range (start > end): {}", line));
-  }
-  return Range{*start, *end};
-}
-
-auto mergeRanges(std::vector<Range> ranges) -> std::vector<Range> {
+constexpr auto mergeRanges(std::vector<Range> ranges) -> std::vector<Range> {
   if (ranges.empty()) {
     return {};
   }
@@ -92,70 +56,181 @@ auto mergeRanges(std::vector<Range> ranges) -> std::vector<Range> {
       });
 }
 
-auto countFreshIngredients(const std::vector<Range> &ranges) -> uint64_t {
+constexpr auto countFreshIngredients(const std::vector<Range> &ranges)
+    -> uint64_t {
   return std::ranges::fold_left(
       ranges, 0ULL,
       [](uint64_t accum, const Range &range) { return accum + range.count(); });
 }
 
-int main(int argc, char *argv[]) {
-  const std::filesystem::path input_file =
-      (argc > 1) ? argv[1] : "../Day5/input";
+// Whether the ID is in any of the fresh ranges; `merged` is sorted and
+// disjoint, as mergeRanges returns it, so this is one binary search
+constexpr bool isFresh(std::span<const Range> merged, uint64_t id) {
+  auto it = std::ranges::lower_bound(merged, id, {}, &Range::end);
+  return it != merged.end() && it->contains(id);
+}
+
+// Available IDs that fall in any of the fresh ranges
+constexpr auto countAvailableFresh(std::span<const Range> merged,
+                                   std::span<const uint64_t> ids) -> uint64_t {
+  return static_cast<uint64_t>(std::ranges::count_if(
+      ids, [merged](uint64_t id) { return isFresh(merged, id); }));
+}
 
-  using RangesType = std::vector<Range>;
-  using IDsType = std::vector<uint64_t>;
+// Whole puzzle over text already in memory; nullopt on a malformed line
+constexpr auto solveText(std::string_view text)
+    -> std::optional<std::pair<uint64_t, uint64_t>> {
+  std::vector<Range> ranges{};
+  std::vector<uint64_t> ids{};
+  bool reading_ids = false;
+  bool parsed = pc::forEachLine(text, [&](std::string_view line) {
+    if (reading_ids) {
+      if (line.empty()) {
+        return true;
+      }
+      auto id = pc::to_unsigned<uint64_t>(line);
+      if (id) {
+        ids.push_back(*id);
+      }
+      return id.has_value();
+    }
+    if (line.empty()) {
+      reading_ids = true;
+      return true;
+    }
+    auto range = parseRange(line);
+    if (range) {
+      ranges.push_back(*range);
+    }
+    return range.has_value();
+  });
+  if (!parsed) {
+    return std::nullopt;
+  }
+  auto merged = mergeRanges(std::move(ranges));
+  return std::pair(countAvailableFresh(merged, ids),
+                   countFreshIngredients(merged));
+}
 
-  IDsType available_ids{};
+// State of an incremental run: the fresh ranges, merged once the IDs start,
+// and the available IDs found fresh so far
+struct FreshTally {
+  struct Counts {
+    uint64_t reading_ids = 0;
+    uint64_t available_fresh = 0;
+  };
+  std::vector<Range> ranges;
+  Counts counts;
+};
 
-  enum class ReadState { Ranges, IDs };
-  ReadState state = ReadState::Ranges;
+// Adds the lines of `text` to the tally; false on a malformed line
+bool addInventory(std::string_view text, FreshTally &tally) {
+  return pc::forEachLine(text, [&tally](std::string_view line) {
+    if (tally.counts.reading_ids) {
+      if (line.empty()) {
+        return true;
+      }
+      auto id = pc::to_unsigned<uint64_t>(line);
+      if (!id) {
+        std::println(stderr, "Error parsing ID: {}", line);
+        return false;
+      }
+      tally.counts.available_fresh += isFresh(tally.ranges, *id) ? 1 : 0;
+      return true;
+    }
+    if (line.empty()) {
+      tally.ranges = mergeRanges(std::move(tally.ranges));
+      tally.counts.reading_ids = 1;
+      return true;
+    }
+    auto range = parseLine(line);
+    if (!range) {
+      std::println(stderr, "Error: {}", range.error());
+      return false;
+    }
+    tally.ranges.push_back(*range);
+    return true;
+  });
+}
 
-  auto result = pc::readFileByLine<RangesType>(
-      input_file,
-      [&available_ids, &state](std::string_view line, RangesType &accumulate) {
-        if (line.empty()) {
-          // Switch to reading available IDs
-          state = ReadState::IDs;
-          return true;
+// Tally of the previous run over this file, with the IDs appended since
+std::expected<FreshTally, bool>
+resumeTally(const std::filesystem::path &input) {
+  return pc::incrementalInput<FreshTally>(
+      "day5", 1, input, addInventory,
+      [](const FreshTally &tally, pc::CacheWriter &state) {
+        state.add(tally.ranges);
+        state.add(std::span<const FreshTally::Counts>(&tally.counts, 1));
+      },
+      [](const pc::CacheReader &state) -> std::expected<FreshTally, bool> {
+        auto ranges = state.vector<Range>(0);
+        auto counts = state.section<FreshTally::Counts>(1);
+        if (!ranges || !counts || counts->size() != 1) {
+          return std::unexpected(false);
         }
-        if (state == ReadState::IDs) {
-          auto id = pc::to_unsigned<uint64_t>(line);
-          if (!id) {
-            std::println(stderr, "Error parsing ID: {}", line);
-            return false;
-          }
-          available_ids.push_back(*id);
-          return true;
-        } else {
-          auto parse_result = parseLine(line);
-          if (!parse_result) {
-            std::println(stderr, "Error: {}", parse_result.error());
-            return false;
-          }
-          accumulate.push_back(*parse_result);
+        return FreshTally{std::move(*ranges), counts->front()};
+      });
+}
+
+int solve(const puzzles::common::SolverContext &ctx) {
+#ifdef PUZZLES_HAS_EMBEDDED_INPUT
+  if (ctx.input == PUZZLES_DEFAULT_INPUT) {
+    static constexpr auto answer = solveText(pc::embeddedInput());
+    static_assert(answer, "Embedded input is malformed");
+    std::println(ctx.out, "{} {}", answer->first, answer->second);
+    return 0;
+  }
+#endif
+
+  // With $PUZZLES_STATE_DIR set only IDs appended since the last run over the
+  // file are looked up
+  if (pc::incrementalMode(ctx.input)) {
+    auto tally = resumeTally(ctx.input);
+    if (!tally) {
+      std::println(stderr, "Error reading file {}", ctx.input.string());
+      return 1;
+    }
+    std::println(ctx.out, "{} {}", tally->counts.available_fresh,
+                 countFreshIngredients(mergeRanges(std::move(tally->ranges))));
+    return 0;
+  }
+
+  // Parsed ranges and IDs come from the cache when this input was seen before
+  auto result = pc::cachedInput<Inventory>(
+      "day5", 1, ctx.input,
+      [](const std::filesystem::path &input) { return readInventory(input); },
+      [](const Inventory &inventory, pc::CacheWriter &cache) {
+        cache.add(inventory.ranges);
+        cache.add(inventory.ids);
+      },
+      [](const pc::CacheReader &cache) -> std::expected<Inventory, bool> {
+        auto ranges = cache.vector<Range>(0);
+        auto ids = cache.vector<uint64_t>(1);
+        if (!ranges || !ids) {
+          return std::unexpected(false);
         }
-        return true;
+        return Inventory{std::move(*ranges), std::move(*ids)};
       });
 
   if (!result) {
-    std::println(stderr, "Error reading file {}", input_file.string());
+    std::println(stderr, "Error reading file {}", ctx.input.string());
     return 1;
   }
 
-  const auto &ranges = result.value();
-
-  auto fresh_count =
-      std::ranges::count_if(available_ids, [ranges](uint64_t id) {
-        return std::ranges::any_of(
-            ranges, [id](const Range &range) { return range.contains(id); });
-      });
-
   // Process using functional pipeline
-  auto ranges_copy = std::move(result.value());
-  auto merged_ranges = mergeRanges(std::move(ranges_copy));
+  PUZZLES_TRACE_BEGIN(merge_scope, "merge ranges");
+  auto merged_ranges = mergeRanges(std::move(result->ranges));
   auto total_fresh = countFreshIngredients(merged_ranges);
+  PUZZLES_TRACE_END(merge_scope);
 
-  std::println("{} {}", fresh_count, total_fresh);
+  PUZZLES_TRACE_BEGIN(count_scope, "count fresh");
+  auto fresh_count = countAvailableFresh(merged_ranges, result->ids);
+  PUZZLES_TRACE_END(count_scope);
+
+  std::println(ctx.out, "{} {}", fresh_count, total_fresh);
 
   return 0;
 }
+} // namespace
+
+PUZZLES_REGISTER_SOLVER("puzzle5", solve)
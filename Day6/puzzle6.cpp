@@ -6,48 +6,44 @@
  * Expected output: 5784380717354
  */
 #include "../common/common.h"
+#include "../common/registry.h"
 #include <algorithm>
 #include <cmath>
 #include <cstdint>
 #include <print>
 #include <ranges>
-#include <regex>
+#include <span>
 #include <vector>
 
-int main(int argc, char *argv[]) {
-
-  const std::filesystem::path input_file =
-      (argc > 1) ? argv[1] : "../Day6/input";
+namespace {
+int solve(const puzzles::common::SolverContext &ctx) {
 
   using ResultType = std::vector<std::vector<int>>;
 
   std::vector<char> o_line{};
+  std::vector<int> row_buffer{};
 
   auto result = puzzles::common::readFileByLine<ResultType>(
-      input_file, [&](std::string_view line, ResultType &groups) {
+      ctx.input, [&](std::string_view line, ResultType &groups) {
         // Check if this is the operator line
         if (line.find('*') != std::string::npos ||
             line.find('+') != std::string::npos) {
           // Parse operators
-          std::regex op_pattern{R"([+*])"};
-          for (std::cregex_iterator it(
-                   &line.data()[0], &line.data()[0] + line.size(), op_pattern),
-               end;
-               it != end; ++it) {
-            o_line.push_back((*it).str()[0]);
+          for (char c : line) {
+            if (c == '+' || c == '*') {
+              o_line.push_back(c);
+            }
           }
         } else {
 
-          // Parse numbers from current row
-          std::vector<int> current_row{};
-          std::regex number_pattern{R"(\d{1,4})"};
-          for (std::cregex_iterator
-                   it(&line.data()[0], &line.data()[0] + line.size(),
-                      number_pattern),
-               end;
-               it != end; ++it) {
-            current_row.push_back(std::stoll(it->str()));
-          }
+          // Parse numbers from current row, a line of n characters holds at
+          // most n / 2 + 1 numbers
+          row_buffer.resize(line.size() / 2 + 1);
+          auto parsed = puzzles::common::parse_integers(line,
+                                                        std::span(row_buffer));
+          if (!parsed)
+            return false;
+          auto current_row = std::span(row_buffer).first(*parsed);
           if (!current_row.empty()) {
             if (groups.empty())
               groups.resize(current_row.size());
@@ -77,6 +73,7 @@ int main(int argc, char *argv[]) {
   };
 
   // First part
+  PUZZLES_TRACE_SCOPE("evaluate groups");
   uint64_t sum = 0;
   for (const auto &[op, gr] : std::views::zip(o_line, d_groups)) {
     if (gr.empty())
@@ -114,7 +111,10 @@ int main(int argc, char *argv[]) {
     }
   }
 
-  std::println("Result {}", sum);
+  std::println(ctx.out, "Result {}", sum);
 
   return 0;
 }
+} // namespace
+
+PUZZLES_REGISTER_SOLVER("puzzle6", solve)
@@ -5,159 +5,116 @@
  * Perform operations on groups of vertical digits extracted from input numbers.
  * Expected output: 7996218225744
  */
-#include "../common/common.h"
+#include "../common/grid.h"
+#include "../common/registry.h"
 #include <algorithm>
 #include <print>
 #include <ranges>
-#include <regex>
 #include <vector>
 
-int main(int argc, char *argv[]) {
+namespace {
+int solve(const puzzles::common::SolverContext &ctx) {
   using namespace std;
+  namespace pc = puzzles::common;
 
-  const std::filesystem::path input_file =
-      (argc > 1) ? argv[1] : "../Day6/input";
-
-  auto result = puzzles::common::readFileByLine<std::vector<std::string>>(
-      input_file,
-      [](std::string_view line, std::vector<std::string> &accumulate) {
-        accumulate.push_back(std::string(line));
-        return true;
-      });
+  // Worksheet cells plus the column layout vectors
+  pc::InputArena arena(ctx.input, 4);
+  auto *resource = arena.resource();
+  // Short lines are padded with spaces to the longest one
+  using Grid = pc::ArenaGrid<char>;
+  auto result =
+      pc::readGrid(ctx.input, 0, ' ', Grid::allocator_type(resource));
 
   if (!result) {
     std::println(stderr, puzzles::common::InputFileError);
     return 1;
   }
 
-  const auto &lines = *result;
-  if (lines.size() < 2) {
+  const Grid &grid = *result;
+  if (grid.rows() < 2) {
     std::println(stderr, "Not enough lines in input");
     return 1;
   }
-
-  // Find maximum line length and pad all lines for correct column processing
-  size_t maxLen = ranges::max(
-      lines | views::transform([](const string &s) { return s.length(); }));
-
-  for (auto &l : *result) {
-    l.resize(maxLen, ' ');
-  }
-
-  // Parse operators from last line using regex
-  string operators = lines.back();
-  regex opPattern(R"([+*])");
-  vector<pair<size_t, char>> opPositions;
-
-  for (sregex_iterator it(operators.begin(), operators.end(), opPattern), end;
-       it != end; ++it) {
-    opPositions.push_back({it->position(), (*it)[0].str()[0]});
-  }
+  const int cols = grid.cols();
+  const int numberRows = grid.rows() - 1;
+  // Operators are in the last line
+  auto operators = grid.row(numberRows);
 
   // Find all columns that are completely empty (all spaces in all rows)
   // Separators
-  vector<bool> isSeparatorColumn(maxLen, true);
-  for (size_t col = 0; col < maxLen; col++) {
-    for (const auto &l : lines) {
-      if (l[col] != ' ') {
-        isSeparatorColumn[col] = false;
-        break;
-      }
-    }
+  PUZZLES_TRACE_BEGIN(layout_scope, "column layout");
+  pmr::vector<char> isSeparatorColumn(cols, 0, resource);
+  for (int col = 0; col < cols; col++) {
+    isSeparatorColumn[col] =
+        ranges::all_of(grid.col(col), [](char c) { return c == ' '; });
   }
 
   // Identify column groups separated by empty columns
-  vector<pair<size_t, size_t>> columnGroups;
-  size_t i = 0;
-  while (i < maxLen) {
+  pmr::vector<pair<int, int>> columnGroups(resource);
+  int i = 0;
+  while (i < cols) {
     // Skip empty columns
-    while (i < maxLen && isSeparatorColumn[i]) {
+    while (i < cols && isSeparatorColumn[i]) {
       i++;
     }
 
-    if (i >= maxLen)
+    if (i >= cols)
       break;
 
     // Found start of a column group
-    size_t groupStart = i;
-    while (i < maxLen && !isSeparatorColumn[i]) {
+    int groupStart = i;
+    while (i < cols && !isSeparatorColumn[i]) {
       i++;
     }
-    size_t groupEnd = i - 1;
+    int groupEnd = i - 1;
 
     columnGroups.push_back({groupStart, groupEnd});
   }
 
+  PUZZLES_TRACE_END(layout_scope);
+
   // Process each column group
-  vector<uint64_t> results;
+  PUZZLES_TRACE_SCOPE("evaluate groups");
+  uint64_t grandTotal = 0;
 
   for (const auto &[groupStart, groupEnd] : columnGroups) {
     // Find operator in this column group
-    char op = ' ';
-    for (const auto &[opPos, opChar] : opPositions) {
-      if (opPos >= groupStart && opPos <= groupEnd) {
-        op = opChar;
-        break;
-      }
-    }
-
-    if (op == ' ')
+    auto group = operators.subspan(groupStart, groupEnd - groupStart + 1);
+    auto opPos = ranges::find_if(group, [](char c) {
+      return c == '+' || c == '*';
+    });
+    if (opPos == group.end())
       continue;
-
-    // Get the width of this group
-    size_t groupWidth = groupEnd - groupStart + 1;
-
-    // For each row (except operator row), reverse the segment to get positions
-    vector<string> reversedRows;
-    for (size_t row = 0; row < lines.size() - 1; row++) {
-      string segment = lines[row].substr(groupStart, groupWidth);
-      ranges::reverse(segment);
-      reversedRows.push_back(segment);
-    }
-
-    // Now each position (column in reversed rows) forms a number vertically
-    vector<uint64_t> numbers;
-
-    for (size_t pos = 0; pos < groupWidth; pos++) {
-      string numStr;
-
-      // Read this position from all rows (top to bottom)
-      for (const auto &revRow : reversedRows) {
-        char ch = revRow[pos];
-        if (ch >= '0' && ch <= '9') {
-          numStr += ch;
+    char op = *opPos;
+
+    // Each column, right to left, forms a number read top to bottom
+    bool anyNumber = false;
+    uint64_t result = op == '*' ? 1 : 0;
+    for (int col = groupEnd; col >= groupStart; col--) {
+      bool hasDigits = false;
+      uint64_t number = 0;
+      for (char ch : grid.col(col) | views::take(numberRows)) {
+        if (pc::is_digit(ch)) {
+          number = number * 10 + (ch - '0');
+          hasDigits = true;
         }
       }
-
-      // Convert to number if we found any digits
-      if (!numStr.empty()) {
-        auto num = puzzles::common::to_unsigned<uint64_t>(numStr);
-        if (num) {
-          numbers.push_back(*num);
-        } else {
-          println(stderr, "Error converting '{}' to number", numStr);
-        }
+      if (hasDigits) {
+        result = op == '*' ? result * number : result + number;
+        anyNumber = true;
       }
     }
 
     // Calculate result for this problem
-    if (!numbers.empty()) {
-      long long result = numbers[0];
-
-      if (op == '+') {
-        result = ranges::fold_left(numbers, 0LL, plus<>());
-      } else if (op == '*') {
-        result = ranges::fold_left(numbers, 1LL, multiplies<>());
-      }
-
-      results.push_back(result);
+    if (anyNumber) {
+      grandTotal += result;
     }
   }
 
-  // Calculate grand total
-  uint64_t grandTotal = ranges::fold_left(results, 0LL, plus<>());
-
-  println("Total: {}", grandTotal);
+  println(ctx.out, "Total: {}", grandTotal);
 
   return 0;
 }
+} // namespace
+
+PUZZLES_REGISTER_SOLVER("puzzle6_2", solve)
@@ -11,182 +11,101 @@
  * Expected output: 1602 135656430050438
  */
 
-#include "../common/common.h"
+#include "../common/grid.h"
+#include "../common/registry.h"
 #include <algorithm>
-#include <filesystem>
-#include <fstream>
+#include <cstdint>
 #include <iostream>
-#include <map>
+#include <numeric>
 #include <print>
-#include <queue>
-#include <set>
 #include <string>
 #include <vector>
 
-struct Beam {
-  int row;
-  int col;
-};
+namespace {
+int solve(const puzzles::common::SolverContext &ctx) {
+  namespace pc = puzzles::common;
+  // Grid cells and the two timeline rows
+  pc::InputArena arena(ctx.input, 4);
+  auto *resource = arena.resource();
 
-int main(int argc, char *argv[]) {
-  const std::filesystem::path input_file =
-      (argc > 1) ? argv[1] : "../Day7/input";
-
-  // Read the grid
-  using ResultType = std::vector<std::string>;
-  int start_row = -1, start_col = -1;
-  auto result = puzzles::common::readFileByLine<ResultType>(
-      input_file, [&](std::string_view line, ResultType &grid) {
-        if (!line.empty()) {
-          // Find starting position 'S'
-          size_t pos = line.find('S');
-          if (pos != std::string::npos) {
-            start_row = grid.size();
-            start_col = pos;
-          }
-          grid.push_back(std::string(line));
-          return true;
-        }
-        return false;
-      });
+  // Read the grid. Beams leaving through the sides are dropped and the ones
+  // leaving through the bottom are counted, so there is no common sentinel
+  // value and the grid has no border.
+  using Grid = pc::ArenaGrid<char>;
+  auto result =
+      pc::readGrid(ctx.input, 0, '.', Grid::allocator_type(resource));
 
   if (!result) {
-    std::println(stderr, "Error reading input file {}", input_file.string());
+    std::println(stderr, "Error reading input file {}", ctx.input.string());
     return 1;
   }
 
+  const Grid &grid = result.value();
+  const int rows = grid.rows();
+  const int cols = grid.cols();
+
+  // Find starting position 'S'
+  int start_row = -1, start_col = -1;
+  for (int row = 0; row < rows && start_row == -1; ++row) {
+    auto cells = grid.row(row);
+    auto pos = std::ranges::find(cells, 'S');
+    if (pos != cells.end()) {
+      start_row = row;
+      start_col = pos - cells.begin();
+    }
+  }
+
   if (start_row == -1) {
     std::println(stderr, "Starting position 'S' not found");
     return 1;
   }
 
-  const ResultType &grid = result.value();
-
-  int rows = grid.size();
-  int cols = grid[0].size();
-
-  //  ============= Part I ==============
-  // BFS to simulate beam propagation
-  // All beams move downward, we just track their column position
-  std::queue<Beam> beams;
-  std::set<std::pair<int, int>>
-      visited; // (row, col) - track which positions have been visited
+  // All beams move downward, so both parts are one sweep over the rows.
+  // timelines[col] is the number of timelines with a particle at (row, col);
+  // a column with any timeline is a beam, which is all Part I needs.
+  PUZZLES_TRACE_SCOPE("propagate beams");
+  std::pmr::vector<uint64_t> timelines(cols, 0, resource);
+  std::pmr::vector<uint64_t> next(cols, 0, resource);
+  timelines[start_col] = 1;
   int split_count = 0;
 
-  // Start with initial beam at S
-  beams.push({start_row, start_col});
-  visited.insert({start_row, start_col});
-
-  while (!beams.empty()) {
-    Beam current = beams.front();
-    beams.pop();
-
-    // Move beam downward
-    int next_row = current.row + 1;
-    int next_col = current.col;
-
-    // Check bounds
-    if (next_row >= rows) {
-      continue; // Beam exits the manifold
-    }
-
-    char cell = grid[next_row][next_col];
-
-    if (cell == '^') {
-      // Hit a splitter - beam stops and splits
-      split_count++;
-
-      // Create left beam starting from immediate left of splitter
-      int left_col = next_col - 1;
-      if (left_col >= 0 &&
-          visited.find({next_row, left_col}) == visited.end()) {
-        visited.insert({next_row, left_col});
-        beams.push({next_row, left_col});
-      }
-
-      // Create right beam starting from immediate right of splitter
-      int right_col = next_col + 1;
-      if (right_col < cols &&
-          visited.find({next_row, right_col}) == visited.end()) {
-        visited.insert({next_row, right_col});
-        beams.push({next_row, right_col});
-      }
-    } else if (cell == '.' || cell == 'S') {
-      // Continue downward
-      if (visited.find({next_row, next_col}) == visited.end()) {
-        visited.insert({next_row, next_col});
-        beams.push({next_row, next_col});
-      }
-    }
-  }
-
-  //  ============= Part II ==============
-  // Use dynamic programming: count[row][col] = number of timelines reaching
-  // this position
-  std::map<std::pair<int, int>, uint64_t> count;
-  count[{start_row, start_col}] = 1;
-
-  // Process row by row from top to bottom
-  for (int row = start_row; row < rows; row++) {
-    std::map<std::pair<int, int>, uint64_t> next_count;
-
-    for (const auto &[pos, num_timelines] : count) {
-      if (pos.first != row)
-        continue;
-
-      int curr_row = pos.first;
-      int curr_col = pos.second;
-
-      // Move downward
-      int next_row = curr_row + 1;
-
-      // Check if we've exited the manifold
-      if (next_row >= rows) {
-        // These timelines exit here - add to final count
-        next_count[{next_row, curr_col}] += num_timelines;
+  for (int row = start_row + 1; row < rows; ++row) {
+    std::ranges::fill(next, 0);
+    auto cells = grid.row(row);
+    for (int col = 0; col < cols; ++col) {
+      uint64_t num_timelines = timelines[col];
+      if (num_timelines == 0) {
         continue;
       }
-
-      char cell = grid[next_row][curr_col];
-
+      char cell = cells[col];
       if (cell == '^') {
-        // Hit a splitter - particle takes BOTH paths
-        // Each timeline splits into two timelines
-
-        // Left path
-        int left_col = curr_col - 1;
-        if (left_col >= 0) {
-          next_count[{next_row, left_col}] += num_timelines;
+        // Hit a splitter - the beam splits and every timeline takes both
+        // paths, starting from the immediate left and right of the splitter
+        split_count++;
+        if (col > 0) {
+          next[col - 1] += num_timelines;
         }
-
-        // Right path
-        int right_col = curr_col + 1;
-        if (right_col < cols) {
-          next_count[{next_row, right_col}] += num_timelines;
+        if (col + 1 < cols) {
+          next[col + 1] += num_timelines;
         }
       } else if (cell == '.' || cell == 'S') {
-        // Continue downward in all timelines
-        next_count[{next_row, curr_col}] += num_timelines;
+        // Continue downward
+        next[col] += num_timelines;
       }
     }
-
-    // Merge next_count into count
-    for (const auto &[pos, num] : next_count) {
-      count[pos] = num;
-    }
+    std::swap(timelines, next);
   }
 
-  // Sum up all timelines that exited the manifold
-  uint64_t total_timelines = 0;
-  for (const auto &[pos, num_timelines] : count) {
-    if (pos.first >= rows) {
-      total_timelines += num_timelines;
-    }
-  }
+  // Everything still moving after the last row exits the manifold
+  uint64_t total_timelines =
+      std::accumulate(timelines.begin(), timelines.end(), uint64_t{0});
 
-  std::println("Total timelines exiting the manifold: {}\n"
+  std::println(ctx.out, "Total timelines exiting the manifold: {}\n"
                "Split counter: {}",
                total_timelines, split_count);
 
   return 0;
 }
+} // namespace
+
+PUZZLES_REGISTER_SOLVER("puzzle7", solve)
@@ -8,8 +8,13 @@
  * Expected output: 122430 8135565324
  */
 
+#include "../common/cache.h"
 #include "../common/common.h"
+#include "../common/cpu_dispatch.h"
+#include "../common/registry.h"
 #include <algorithm>
+#include <array>
+#include <bit>
 #include <cmath>
 #include <cstdint>
 #include <filesystem>
@@ -17,10 +22,10 @@
 #include <iostream>
 #include <print>
 #include <ranges>
-#include <sstream>
 #include <string>
 #include <vector>
 
+namespace {
 struct Point3D {
   int x, y, z;
 };
@@ -103,27 +108,138 @@ double calculateDistance(const Point3D &a, const Point3D &b) {
   return std::sqrt(dx * dx + dy * dy + dz * dz);
 }
 
-int main(int argc, char *argv[]) {
+// Coordinates as columns, so the distances from one box to a run of others
+// are a vector loop
+struct BoxColumns {
+  std::vector<int> x, y, z;
+};
+
+// Distances from `from` to boxes [begin, begin + count) into out
+using DistancesFn = void(const Point3D &from, const BoxColumns &boxes,
+                         size_t begin, size_t count, double *out);
+
+void distancesScalar(const Point3D &from, const BoxColumns &boxes,
+                     size_t begin, size_t count, double *out) {
+  for (size_t k = 0; k < count; ++k) {
+    const size_t j = begin + k;
+    out[k] = calculateDistance(from, {boxes.x[j], boxes.y[j], boxes.z[j]});
+  }
+}
+
+// The vector variants work in doubles, which gives the same distances as
+// calculateDistance while the squares add up exactly: every coordinate has
+// to be below CoordinateLimit in magnitude
+constexpr int CoordinateLimit = 1 << 24;
+
+#ifdef PUZZLES_HAS_CPU_DISPATCH
+void distancesSSE2(const Point3D &from, const BoxColumns &boxes, size_t begin,
+                   size_t count, double *out) {
+  const __m128d x = _mm_set1_pd(from.x);
+  const __m128d y = _mm_set1_pd(from.y);
+  const __m128d z = _mm_set1_pd(from.z);
+  auto column = [begin](const std::vector<int> &values, size_t k) {
+    return _mm_cvtepi32_pd(_mm_loadl_epi64(
+        reinterpret_cast<const __m128i *>(values.data() + begin + k)));
+  };
+  size_t k = 0;
+  for (; k + 2 <= count; k += 2) {
+    __m128d dx = _mm_sub_pd(x, column(boxes.x, k));
+    __m128d dy = _mm_sub_pd(y, column(boxes.y, k));
+    __m128d dz = _mm_sub_pd(z, column(boxes.z, k));
+    __m128d sum = _mm_add_pd(_mm_add_pd(_mm_mul_pd(dx, dx), _mm_mul_pd(dy, dy)),
+                             _mm_mul_pd(dz, dz));
+    _mm_storeu_pd(out + k, _mm_sqrt_pd(sum));
+  }
+  distancesScalar(from, boxes, begin + k, count - k, out + k);
+}
+
+PUZZLES_TARGET_AVX2 __m256d columnAVX2(const std::vector<int> &values,
+                                       size_t index) {
+  return _mm256_cvtepi32_pd(_mm_loadu_si128(
+      reinterpret_cast<const __m128i *>(values.data() + index)));
+}
+
+PUZZLES_TARGET_AVX2 void distancesAVX2(const Point3D &from,
+                                       const BoxColumns &boxes, size_t begin,
+                                       size_t count, double *out) {
+  const __m256d x = _mm256_set1_pd(from.x);
+  const __m256d y = _mm256_set1_pd(from.y);
+  const __m256d z = _mm256_set1_pd(from.z);
+  size_t k = 0;
+  for (; k + 4 <= count; k += 4) {
+    __m256d dx = _mm256_sub_pd(x, columnAVX2(boxes.x, begin + k));
+    __m256d dy = _mm256_sub_pd(y, columnAVX2(boxes.y, begin + k));
+    __m256d dz = _mm256_sub_pd(z, columnAVX2(boxes.z, begin + k));
+    __m256d sum = _mm256_add_pd(
+        _mm256_add_pd(_mm256_mul_pd(dx, dx), _mm256_mul_pd(dy, dy)),
+        _mm256_mul_pd(dz, dz));
+    _mm256_storeu_pd(out + k, _mm256_sqrt_pd(sum));
+  }
+  distancesSSE2(from, boxes, begin + k, count - k, out + k);
+}
+
+PUZZLES_TARGET_AVX512 __m512d columnAVX512(const std::vector<int> &values,
+                                           size_t index) {
+  return _mm512_cvtepi32_pd(_mm256_loadu_si256(
+      reinterpret_cast<const __m256i *>(values.data() + index)));
+}
+
+PUZZLES_TARGET_AVX512 void distancesAVX512(const Point3D &from,
+                                           const BoxColumns &boxes,
+                                           size_t begin, size_t count,
+                                           double *out) {
+  const __m512d x = _mm512_set1_pd(from.x);
+  const __m512d y = _mm512_set1_pd(from.y);
+  const __m512d z = _mm512_set1_pd(from.z);
+  size_t k = 0;
+  for (; k + 8 <= count; k += 8) {
+    __m512d dx = _mm512_sub_pd(x, columnAVX512(boxes.x, begin + k));
+    __m512d dy = _mm512_sub_pd(y, columnAVX512(boxes.y, begin + k));
+    __m512d dz = _mm512_sub_pd(z, columnAVX512(boxes.z, begin + k));
+    __m512d sum = _mm512_add_pd(
+        _mm512_add_pd(_mm512_mul_pd(dx, dx), _mm512_mul_pd(dy, dy)),
+        _mm512_mul_pd(dz, dz));
+    _mm512_storeu_pd(out + k, _mm512_sqrt_pd(sum));
+  }
+  distancesAVX2(from, boxes, begin + k, count - k, out + k);
+}
+#endif
+
+constexpr puzzles::common::KernelVariants<DistancesFn> Distances{
+    .scalar = distancesScalar,
+#ifdef PUZZLES_HAS_CPU_DISPATCH
+    .sse2 = distancesSSE2,
+    .avx2 = distancesAVX2,
+    .avx512 = distancesAVX512,
+#endif
+};
+
+int solve(const puzzles::common::SolverContext &ctx) {
   namespace cp = puzzles::common;
-  const std::filesystem::path input_file{(argc > 1) ? argv[1]
-                                                    : "../Day8/input"};
-  const int TARGET_CONNECTIONS = (argc > 2) ? std::stoi(argv[2]) : 1000;
+  const int TARGET_CONNECTIONS =
+      ctx.args.empty() ? 1000 : std::stoi(std::string(ctx.args[0]));
 
-  // Read junction box positions
+  // Read junction box positions, or load them from the parsed input cache
   using ResultType = std::vector<Point3D>;
-  auto result_boxes = cp::readFileByLine<ResultType>(
-      input_file, [](std::string_view line, ResultType &boxes) -> bool {
-        if (line.empty())
-          return false;
-
-        std::istringstream iss(line.data());
-        Point3D point;
-        char comma;
-
-        if (iss >> point.x >> comma >> point.y >> comma >> point.z) {
-          boxes.push_back(point);
-        }
-        return true;
+  auto result_boxes = cp::cachedInput<ResultType>(
+      "day8", 1, ctx.input,
+      [](const std::filesystem::path &input) {
+        return cp::readFileByLine<ResultType>(
+            input, [](std::string_view line, ResultType &boxes) -> bool {
+              if (line.empty())
+                return false;
+
+              std::array<int, 3> xyz{};
+              auto fields = cp::parse_integers(line, std::span(xyz));
+              if (fields && *fields == xyz.size()) {
+                boxes.push_back(Point3D{xyz[0], xyz[1], xyz[2]});
+              }
+              return true;
+            });
+      },
+      [](const ResultType &boxes, cp::CacheWriter &cache) { cache.add(boxes); },
+      [](const cp::CacheReader &cache) {
+        return cache.vector<Point3D>(0);
       });
 
   if (!result_boxes) {
@@ -136,23 +252,45 @@ int main(int argc, char *argv[]) {
   int n = boxes.size();
 
   // Generate all possible edges with distances
+  PUZZLES_TRACE_BEGIN(edges_scope, "generate edges");
+  BoxColumns columns;
+  bool exact = true;
+  for (const auto &box : boxes) {
+    columns.x.push_back(box.x);
+    columns.y.push_back(box.y);
+    columns.z.push_back(box.z);
+    for (int value : {box.x, box.y, box.z}) {
+      exact = exact && value > -CoordinateLimit && value < CoordinateLimit;
+    }
+  }
+  auto *distances =
+      Distances.select(exact ? cp::cpuTier() : cp::CpuTier::Scalar);
+
   std::vector<Edge> edges;
+  edges.reserve(boxes.size() * (boxes.size() - 1) / 2);
+  std::vector<double> row(boxes.size());
   for (const auto &[idx1, box1] : boxes | std::views::enumerate) {
-    for (const auto &[idx2, box2] :
-         boxes | std::views::enumerate | std::views::drop(idx1 + 1)) {
+    const size_t begin = idx1 + 1;
+    distances(box1, columns, begin, boxes.size() - begin, row.data());
+    for (size_t idx2 = begin; idx2 < boxes.size(); ++idx2) {
       edges.emplace_back(Edge{.from = static_cast<int>(idx1),
                               .to = static_cast<int>(idx2),
-                              .distance = calculateDistance(box1, box2)});
+                              .distance = row[idx2 - begin]});
     }
   }
 
+  PUZZLES_TRACE_END(edges_scope);
+
   // Sort edges by distance (shortest first)
+  PUZZLES_TRACE_BEGIN(sort_scope, "sort edges");
   std::sort(edges.begin(), edges.end());
+  PUZZLES_TRACE_END(sort_scope);
 
   UnionFind uf(n);
 
   // ========== Part 1 ==========
   // Use Union-Find to connect boxes
+  PUZZLES_TRACE_BEGIN(part1_scope, "part 1 union-find");
   for (const auto &edge : edges | std::views::take(TARGET_CONNECTIONS)) {
     uf.unite(edge.from, edge.to); // Try to unite, even if already connected
   }
@@ -167,9 +305,12 @@ int main(int argc, char *argv[]) {
   uint64_t result = std::ranges::fold_left(circuit_sizes | std::views::take(3),
                                            1ULL, std::multiplies<uint64_t>{});
 
-  std::println("Part 1: {}", result);
+  PUZZLES_TRACE_END(part1_scope);
+
+  std::println(ctx.out, "Part 1: {}", result);
 
   // ========== Part 2 ==========
+  PUZZLES_TRACE_BEGIN(part2_scope, "part 2 union-find");
   int last_from = -1, last_to = -1;
 
   for (const auto &edge : edges) {
@@ -183,11 +324,13 @@ int main(int argc, char *argv[]) {
     }
   }
 
+  PUZZLES_TRACE_END(part2_scope);
+
   // Calculate product of X coordinates of the last connection
   if (last_from != -1 && last_to != -1) {
     int64_t result = static_cast<int64_t>(boxes[last_from].x) *
                      static_cast<int64_t>(boxes[last_to].x);
-    std::println("Part 2: {}", result);
+    std::println(ctx.out, "Part 2: {}", result);
   } else {
     std::println(stderr, "Error: Could not find last connection");
     return 1;
@@ -195,3 +338,6 @@ int main(int argc, char *argv[]) {
 
   return 0;
 }
+} // namespace
+
+PUZZLES_REGISTER_SOLVER("puzzle8", solve)
@@ -0,0 +1,161 @@
+#pragma once
+
+// Point-in-polygon test of Day 9 part 2: the ray casting reference and its
+// vector variants, shared by the solver and the differential tests.
+
+#include "../common/cpu_dispatch.h"
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace puzzles::day9 {
+
+struct Point {
+  int64_t x, y;
+
+  bool operator<(const Point &other) const {
+    return x < other.x || (x == other.x && y < other.y);
+  }
+
+  bool operator==(const Point &other) const {
+    return x == other.x && y == other.y;
+  }
+};
+
+// Polygon sides as columns: side k runs from vertex k back to the vertex
+// before it, so the vector variants below load several sides at once
+struct PolygonSides {
+  std::vector<int64_t> xi, yi, xj, yj;
+
+  explicit PolygonSides(const std::vector<Point> &polygon) {
+    for (size_t i = 0, j = polygon.size() - 1; i < polygon.size(); j = i++) {
+      xi.push_back(polygon[i].x);
+      yi.push_back(polygon[i].y);
+      xj.push_back(polygon[j].x);
+      yj.push_back(polygon[j].y);
+    }
+  }
+
+  size_t size() const { return xi.size(); }
+};
+
+// Whether side k lies on a line through p, which counts as inside
+inline bool onSideLine(const PolygonSides &sides, size_t k, const Point &p) {
+  return (sides.yj[k] == sides.yi[k] && sides.yi[k] == p.y) ||
+         (sides.xj[k] == sides.xi[k] && sides.xi[k] == p.x);
+}
+
+// Whether side k crosses the ray from p towards +x
+inline bool crossesRay(const PolygonSides &sides, size_t k, const Point &p) {
+  const int64_t xi = sides.xi[k], yi = sides.yi[k];
+  const int64_t xj = sides.xj[k], yj = sides.yj[k];
+  return ((yi > p.y) != (yj > p.y)) &&
+         (p.x < (xj - xi) * (p.y - yi) / (yj - yi) + xi);
+}
+
+// Check if a point is inside the polygon using ray casting algorithm.
+// Starts at side `first` with the parity `inside` of the sides before it.
+inline bool isInsidePolygon(const PolygonSides &sides, const Point &p,
+                            size_t first = 0, bool inside = false) {
+  for (size_t k = first; k < sides.size(); ++k) {
+    if (onSideLine(sides, k, p))
+      return true; // on vertex
+
+    if (crossesRay(sides, k, p)) {
+      inside = !inside;
+    }
+  }
+  return inside;
+}
+
+// The vector variants test 4 or 8 sides at a time. A vertical side that
+// straddles p crosses the ray exactly when p is left of it; other
+// straddling sides are rare in the rectilinear inputs and go through
+// crossesRay one by one.
+#ifdef PUZZLES_HAS_CPU_DISPATCH
+PUZZLES_TARGET_AVX2 inline __m256i
+loadSides(const std::vector<int64_t> &column, size_t k) {
+  return _mm256_loadu_si256(
+      reinterpret_cast<const __m256i *>(column.data() + k));
+}
+
+// One bit per side of a compare result
+PUZZLES_TARGET_AVX2 inline unsigned sideBits(__m256i mask) {
+  return static_cast<unsigned>(_mm256_movemask_pd(_mm256_castsi256_pd(mask)));
+}
+
+PUZZLES_TARGET_AVX2 inline bool isInsidePolygonAVX2(const PolygonSides &sides,
+                                                    const Point &p) {
+  const __m256i px = _mm256_set1_epi64x(p.x);
+  const __m256i py = _mm256_set1_epi64x(p.y);
+  bool inside = false;
+  size_t k = 0;
+  for (; k + 4 <= sides.size(); k += 4) {
+    __m256i xi = loadSides(sides.xi, k), yi = loadSides(sides.yi, k);
+    __m256i xj = loadSides(sides.xj, k), yj = loadSides(sides.yj, k);
+    __m256i vertical = _mm256_cmpeq_epi64(xj, xi);
+    __m256i on_line = _mm256_or_si256(
+        _mm256_and_si256(_mm256_cmpeq_epi64(yj, yi),
+                         _mm256_cmpeq_epi64(yi, py)),
+        _mm256_and_si256(vertical, _mm256_cmpeq_epi64(xi, px)));
+    if (!_mm256_testz_si256(on_line, on_line)) {
+      return true; // on vertex
+    }
+    __m256i straddles = _mm256_xor_si256(_mm256_cmpgt_epi64(yi, py),
+                                         _mm256_cmpgt_epi64(yj, py));
+    unsigned crossing = sideBits(_mm256_and_si256(
+        _mm256_and_si256(straddles, vertical), _mm256_cmpgt_epi64(xi, px)));
+    inside ^= (std::popcount(crossing) & 1) != 0;
+    for (unsigned slanted =
+             sideBits(_mm256_andnot_si256(vertical, straddles));
+         slanted != 0; slanted &= slanted - 1) {
+      inside ^= crossesRay(sides, k + std::countr_zero(slanted), p);
+    }
+  }
+  return isInsidePolygon(sides, p, k, inside);
+}
+
+PUZZLES_TARGET_AVX512 inline bool
+isInsidePolygonAVX512(const PolygonSides &sides, const Point &p) {
+  const __m512i px = _mm512_set1_epi64(p.x);
+  const __m512i py = _mm512_set1_epi64(p.y);
+  bool inside = false;
+  size_t k = 0;
+  for (; k + 8 <= sides.size(); k += 8) {
+    __m512i xi = _mm512_loadu_si512(sides.xi.data() + k);
+    __m512i yi = _mm512_loadu_si512(sides.yi.data() + k);
+    __m512i xj = _mm512_loadu_si512(sides.xj.data() + k);
+    __m512i yj = _mm512_loadu_si512(sides.yj.data() + k);
+    __mmask8 vertical = _mm512_cmpeq_epi64_mask(xj, xi);
+    __mmask8 on_line = (_mm512_cmpeq_epi64_mask(yj, yi) &
+                        _mm512_cmpeq_epi64_mask(yi, py)) |
+                       (vertical & _mm512_cmpeq_epi64_mask(xi, px));
+    if (on_line != 0) {
+      return true; // on vertex
+    }
+    __mmask8 straddles =
+        _mm512_cmpgt_epi64_mask(yi, py) ^ _mm512_cmpgt_epi64_mask(yj, py);
+    unsigned crossing = straddles & vertical & _mm512_cmpgt_epi64_mask(xi, px);
+    inside ^= (std::popcount(crossing) & 1) != 0;
+    for (unsigned slanted = straddles & ~vertical & 0xFFu; slanted != 0;
+         slanted &= slanted - 1) {
+      inside ^= crossesRay(sides, k + std::countr_zero(slanted), p);
+    }
+  }
+  return isInsidePolygon(sides, p, k, inside);
+}
+#endif
+
+using InsidePolygonFn = bool(const PolygonSides &, const Point &);
+
+inline constexpr common::KernelVariants<InsidePolygonFn> InsidePolygon{
+    .scalar = [](const PolygonSides &sides,
+                 const Point &p) { return isInsidePolygon(sides, p); },
+#ifdef PUZZLES_HAS_CPU_DISPATCH
+    .avx2 = isInsidePolygonAVX2,
+    .avx512 = isInsidePolygonAVX512,
+#endif
+};
+
+} // namespace puzzles::day9
@@ -6,8 +6,11 @@
  * Expected output: 4771532800
  */
 
+#include "../common/cache.h"
 #include "../common/common.h"
+#include "../common/registry.h"
 #include <algorithm>
+#include <array>
 #include <cstdint>
 #include <filesystem>
 #include <fstream>
@@ -15,10 +18,10 @@
 #include <print>
 #include <ranges>
 #include <set>
-#include <sstream>
 #include <string>
 #include <vector>
 
+namespace {
 struct Point {
   int64_t x, y;
 
@@ -31,27 +34,29 @@ struct Point {
   }
 };
 
-int main(int argc, char *argv[]) {
-  const std::filesystem::path input_file{(argc > 1) ? argv[1]
-                                                    : "../../Day9/input"};
-
-  // Read red tile positions
+int solve(const puzzles::common::SolverContext &ctx) {
+  namespace pc = puzzles::common;
+  // Read red tile positions, or load them from the parsed input cache
   using ResultType = std::vector<Point>;
-  auto result_tiles = puzzles::common::readFileByLine<ResultType>(
-      input_file, [](std::string_view line, ResultType &tiles) -> bool {
-        if (line.empty())
-          return true;
-
-        Point point;
-        char comma;
-        std::istringstream iss{std::string(line)};
-
-        if (iss >> point.x >> comma >> point.y) {
-          tiles.push_back(point);
-          return true;
-        }
-        return false;
-      });
+  auto result_tiles = pc::cachedInput<ResultType>(
+      "day9", 1, ctx.input,
+      [](const std::filesystem::path &input) {
+        return pc::readFileByLine<ResultType>(
+            input, [](std::string_view line, ResultType &tiles) -> bool {
+              if (line.empty())
+                return true;
+
+              std::array<int64_t, 2> xy{};
+              auto fields = pc::parse_integers(line, std::span(xy));
+              if (fields && *fields == xy.size()) {
+                tiles.push_back(Point{xy[0], xy[1]});
+                return true;
+              }
+              return false;
+            });
+      },
+      [](const ResultType &tiles, pc::CacheWriter &cache) { cache.add(tiles); },
+      [](const pc::CacheReader &cache) { return cache.vector<Point>(0); });
 
   if (!result_tiles) {
     std::println(stderr, "Error reading input file");
@@ -63,6 +68,7 @@ int main(int argc, char *argv[]) {
   int64_t max_area = 0;
 
   // Try all pairs of tiles as opposite corners
+  PUZZLES_TRACE_SCOPE("largest rectangle");
   for (size_t i = 0; i < tiles.size(); i++) {
     for (size_t j = i + 1; j < tiles.size(); j++) {
       const auto &p1 = tiles[i];
@@ -83,7 +89,10 @@ int main(int argc, char *argv[]) {
     }
   }
 
-  std::println("{}", max_area);
+  std::println(ctx.out, "{}", max_area);
 
   return 0;
 }
+} // namespace
+
+PUZZLES_REGISTER_SOLVER("puzzle9", solve)
@@ -4,90 +4,66 @@
  *
  * Find the largest rectangle that uses red tiles for two opposite corners
  * and only contains red or green tiles inside.
- * Uses OpenMP to parallelize the point-in-polygon checks.
+ * Uses the common thread pool to parallelize the point-in-polygon checks.
  * Command line argument 2 can be used to skip a number of largest areas
  *  ./puzzle9_2 ../../Day9/input 49062
  * Expected output:
  *  4771532800 1544362560
  */
 
+#include "../common/cache.h"
 #include "../common/common.h"
+#include "../common/registry.h"
+#include "../common/thread_pool.h"
+#include "polygon.h"
 #include <algorithm>
-#include <atomic>
+#include <array>
 #include <cstdint>
 #include <filesystem>
 #include <fstream>
 #include <iostream>
-#include <omp.h>
 #include <print>
 #include <ranges>
 #include <set>
-#include <sstream>
 #include <string>
 #include <vector>
 
-struct Point {
-  int64_t x, y;
+namespace {
+using puzzles::day9::InsidePolygon;
+using puzzles::day9::Point;
+using puzzles::day9::PolygonSides;
 
-  bool operator<(const Point &other) const {
-    return x < other.x || (x == other.x && y < other.y);
-  }
-
-  bool operator==(const Point &other) const {
-    return x == other.x && y == other.y;
-  }
-};
-
-// Check if a point is inside the polygon using ray casting algorithm
-bool isInsidePolygon(const Point &p, const std::vector<Point> &polygon) {
-  int n = polygon.size();
-  bool inside = false;
-
-  for (int i = 0, j = n - 1; i < n; j = i++) {
-    const auto &pi = polygon[i];
-    const auto &pj = polygon[j];
-
-    if ((pj.y == pi.y && pi.y == p.y) || (pj.x == pi.x && pi.x == p.x))
-      return true; // on vertex
-
-    if (((pi.y > p.y) != (pj.y > p.y)) &&
-        (p.x < (pj.x - pi.x) * (p.y - pi.y) / (pj.y - pi.y) + pi.x)) {
-      inside = !inside;
-    }
-  }
-
-  return inside;
-}
-
-int main(int argc, char *argv[]) {
+int solve(const puzzles::common::SolverContext &ctx) {
   namespace pc = puzzles::common;
-  const std::filesystem::path input_file{
-      (argc > 1) ? argv[1] : "../../Day9/test_input.txt"};
-  const int START_POSITION = (argc > 2) ? std::stoi(argv[2]) : 0;
-  std::println("File: {} Start position: {}", input_file.string(),
+  const int START_POSITION =
+      ctx.args.empty() ? 0 : std::stoi(std::string(ctx.args[0]));
+  std::println(ctx.out, "File: {} Start position: {}", ctx.input.string(),
                START_POSITION);
 
-  // Set number of threads
-  int num_threads = omp_get_max_threads();
-  std::println("Using {} OpenMP threads", num_threads);
+  // Threads come from $PUZZLES_THREADS or the hardware
+  std::println(ctx.out, "Using {} threads", pc::ThreadPool::global().size());
 
-  // Read red tile positions
+  // Read red tile positions, or load them from the parsed input cache
   using ResultType = std::vector<Point>;
-  auto result_tiles = pc::readFileByLine<ResultType>(
-      input_file, [](std::string_view line, ResultType &tiles) -> bool {
-        if (line.empty())
-          return true;
-
-        Point point;
-        char comma;
-        std::istringstream iss{std::string(line)};
-
-        if (iss >> point.x >> comma >> point.y) {
-          tiles.push_back(point);
-          return true;
-        }
-        return false;
-      });
+  auto result_tiles = pc::cachedInput<ResultType>(
+      "day9", 1, ctx.input,
+      [](const std::filesystem::path &input) {
+        return pc::readFileByLine<ResultType>(
+            input, [](std::string_view line, ResultType &tiles) -> bool {
+              if (line.empty())
+                return true;
+
+              std::array<int64_t, 2> xy{};
+              auto fields = pc::parse_integers(line, std::span(xy));
+              if (fields && *fields == xy.size()) {
+                tiles.push_back(Point{xy[0], xy[1]});
+                return true;
+              }
+              return false;
+            });
+      },
+      [](const ResultType &tiles, pc::CacheWriter &cache) { cache.add(tiles); },
+      [](const pc::CacheReader &cache) { return cache.vector<Point>(0); });
 
   if (!result_tiles) {
     std::println(stderr, pc::InputFileError);
@@ -95,6 +71,8 @@ int main(int argc, char *argv[]) {
   }
 
   auto &red_tiles = result_tiles.value();
+  const PolygonSides sides(red_tiles);
+  auto *inside_polygon = InsidePolygon.select();
 
   int64_t max_area = 0;
 
@@ -107,6 +85,7 @@ int main(int argc, char *argv[]) {
   std::vector<std::tuple<int64_t, int64_t, int64_t, int64_t, int64_t>> areas{};
 
   // Generate all possible rectangles defined by pairs of red tiles
+  PUZZLES_TRACE_BEGIN(generate_scope, "generate areas");
   for (size_t i = 0; i < red_tiles.size(); i++) {
     for (size_t j = i + 1; j < red_tiles.size(); j++) {
       const auto &p1 = red_tiles[i];
@@ -130,29 +109,37 @@ int main(int argc, char *argv[]) {
     }
   }
 
+  PUZZLES_TRACE_END(generate_scope);
+
+  PUZZLES_TRACE_BEGIN(sort_scope, "sort areas");
   std::sort(areas.rbegin(), areas.rend(), [](const auto &a, const auto &b) {
     return std::get<AREA>(a) < std::get<AREA>(b);
   });
+  PUZZLES_TRACE_END(sort_scope);
 
   int drop = START_POSITION; // Skip first N areas already checked
   int area_count = drop;
   for (const auto &area : areas | std::views::drop(drop)) {
-    std::println("Trying area {} from {}: {}", area_count++, areas.size(),
-                 std::get<AREA>(area));
-    std::atomic<bool> all_valid{true};
+    PUZZLES_TRACE_SCOPE("check area");
+    std::println(ctx.out, "Trying area {} from {}: {}", area_count++,
+                 areas.size(), std::get<AREA>(area));
     const int64_t min_x = std::get<MIN_X>(area);
     const int64_t max_x = std::get<MAX_X>(area);
     const int64_t min_y = std::get<MIN_Y>(area);
     const int64_t max_y = std::get<MAX_Y>(area);
 
-#pragma omp parallel for schedule(dynamic)
-    for (int64_t x = min_x; x <= max_x; x++) {
-      for (int64_t y = min_y; y <= max_y && all_valid; y++) {
-        if (!isInsidePolygon({x, y}, red_tiles)) {
-          all_valid = false;
-        }
-      }
-    }
+    // One column per iteration; the first tile outside the polygon cancels
+    // the columns that have not started yet
+    bool all_valid = pc::parallel_for(
+        min_x, max_x + 1,
+        [&](int64_t x) {
+          for (int64_t y = min_y; y <= max_y; y++) {
+            if (!inside_polygon(sides, {x, y})) {
+              return false;
+            }
+          }
+          return true;
+        });
 
     if (all_valid) {
       max_area = std::get<AREA>(area);
@@ -160,7 +147,10 @@ int main(int argc, char *argv[]) {
     }
   }
 
-  std::println("{} {}", std::get<0>(areas.front()), max_area);
+  std::println(ctx.out, "{} {}", std::get<0>(areas.front()), max_area);
 
   return 0;
 }
+} // namespace
+
+PUZZLES_REGISTER_SOLVER("puzzle9_2", solve)
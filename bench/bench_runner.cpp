@@ -0,0 +1,749 @@
+/*
+ * Benchmark runner
+ * Runs every puzzle executable listed in the targets file with warmups and
+ * repetitions, checks stdout against the expected answers and reports
+ * min/median/p99 wall time and peak RSS, plus a JSON report.
+ * Usage:
+ *   bench_runner --config targets.txt --source-dir DIR
+ *                --target name=path [--target name=path ...]
+ *                [--runs N] [--warmups N] [--report report.json]
+ *                [--check-budgets] [--cache-dir DIR] [--perf] [--allocs]
+ * With --cache-dir every target is also timed with the parsed input cache
+ * (common/cache.h): cold runs start from an empty DIR, warm runs reuse the
+ * cache file the cold runs left behind. The plain runs never see a cache.
+ * With --perf one more run collects wall time and hardware counters per
+ * phase (common/perf_counters.h); the puzzles have to be built with
+ * -DPUZZLES_PERF_COUNTERS=ON, and counters the kernel refuses show as "-".
+ * With --allocs another run reports heap allocations, bytes and peak live
+ * bytes per phase, for puzzles built with -DPUZZLES_COUNT_ALLOCS=ON.
+ * Exit status is non-zero when a run fails, an answer does not match or,
+ * with --check-budgets, a median exceeds the target's budget.
+ */
+
+#include "../common/common.h"
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <fcntl.h>
+#include <map>
+#include <optional>
+#include <print>
+#include <spawn.h>
+#include <string>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+extern char **environ;
+
+namespace {
+namespace pc = puzzles::common;
+
+struct TargetSpec {
+  std::string name;
+  double budget_ms = 0.0;
+  int runs = 0; // 0 - use --runs
+  std::vector<std::string> args;
+  std::vector<std::string> expected;
+};
+
+struct RunResult {
+  double wall_ms = 0.0;
+  long max_rss_kb = 0;
+  std::string output;
+};
+
+// Totals of one traced phase; counters are in PerfCounterNames order and
+// nullopt where unavailable
+struct PhaseReport {
+  std::string name;
+  uint64_t calls = 0;
+  double wall_ms = 0.0;
+  std::vector<std::optional<uint64_t>> counters;
+};
+
+constexpr std::array<std::string_view, 5> PerfCounterNames{
+    "cycles", "instructions", "cache-misses", "branch-misses", "dtlb-misses"};
+
+// Heap allocations of one traced phase, or of the whole run
+struct AllocationReport {
+  std::string name;
+  uint64_t calls = 0;
+  uint64_t allocations = 0;
+  uint64_t bytes = 0;
+  uint64_t peak_live_bytes = 0;
+};
+
+struct TargetReport {
+  std::string name;
+  std::string status; // ok, mismatch, failed, missing
+  std::vector<double> times_ms;
+  std::vector<double> cold_ms; // parsed input cache, empty without --cache-dir
+  std::vector<double> warm_ms;
+  std::vector<PhaseReport> phases; // empty without --perf
+  std::string perf_note;
+  std::optional<AllocationReport> allocations; // without --allocs: nullopt
+  std::vector<AllocationReport> alloc_phases;
+  std::string alloc_note;
+  long max_rss_kb = 0;
+  double budget_ms = 0.0;
+  bool over_budget = false;
+  std::string detail;
+};
+
+// Config lines: name budget_ms runs args expected...
+// runs is "-" for the default, args are comma separated ("-" for none)
+std::expected<std::vector<TargetSpec>, bool>
+readConfig(const std::filesystem::path &config) {
+  return pc::readFileByLine<std::vector<TargetSpec>>(
+      config, [](std::string_view line, std::vector<TargetSpec> &specs) {
+        size_t pos = 0;
+        auto name = pc::next_word(line, pos);
+        if (name.empty() || name.front() == '#') {
+          return true;
+        }
+        auto budget = pc::next_word(line, pos);
+        auto runs = pc::next_word(line, pos);
+        auto args = pc::next_word(line, pos);
+        auto budget_ms = pc::to_unsigned<unsigned>(budget);
+        if (!budget_ms || runs.empty() || args.empty()) {
+          std::println(stderr, "Malformed bench config line: {}", line);
+          return false;
+        }
+
+        TargetSpec spec{};
+        spec.name = name;
+        spec.budget_ms = static_cast<double>(*budget_ms);
+        if (runs != "-") {
+          auto count = pc::to_unsigned<unsigned>(runs);
+          if (!count) {
+            std::println(stderr, "Malformed run count: {}", line);
+            return false;
+          }
+          spec.runs = static_cast<int>(*count);
+        }
+        if (args != "-") {
+          for (size_t begin = 0; begin <= args.size();) {
+            size_t end = std::min(args.find(',', begin), args.size());
+            spec.args.emplace_back(args.substr(begin, end - begin));
+            begin = end + 1;
+          }
+        }
+        for (auto word = pc::next_word(line, pos); !word.empty();
+             word = pc::next_word(line, pos)) {
+          spec.expected.emplace_back(word);
+        }
+        specs.push_back(std::move(spec));
+        return true;
+      });
+}
+
+constexpr std::string_view CacheDirVariable = "PUZZLES_CACHE_DIR";
+constexpr std::string_view PerfFileVariable = "PUZZLES_PERF_FILE";
+constexpr std::string_view AllocFileVariable = "PUZZLES_ALLOC_FILE";
+
+// Our environment without the variables the runner controls, plus the given
+// "NAME=value" settings
+std::vector<std::string>
+childEnvironment(const std::vector<std::string> &settings = {}) {
+  auto controlled = [](std::string_view entry) {
+    for (auto name :
+         {CacheDirVariable, PerfFileVariable, AllocFileVariable}) {
+      if (entry.starts_with(name) &&
+          entry.substr(name.size()).starts_with('=')) {
+        return true;
+      }
+    }
+    return false;
+  };
+  std::vector<std::string> env;
+  for (char **var = environ; *var; ++var) {
+    if (!controlled(*var)) {
+      env.emplace_back(*var);
+    }
+  }
+  env.insert(env.end(), settings.begin(), settings.end());
+  return env;
+}
+
+// Spawn the program with stdout captured and stderr discarded
+std::expected<RunResult, std::string>
+runOnce(const std::filesystem::path &program,
+        const std::vector<std::string> &args,
+        const std::vector<std::string> &env) {
+  int out_pipe[2];
+  if (::pipe(out_pipe) != 0) {
+    return std::unexpected("pipe() failed");
+  }
+
+  posix_spawn_file_actions_t actions;
+  posix_spawn_file_actions_init(&actions);
+  posix_spawn_file_actions_adddup2(&actions, out_pipe[1], STDOUT_FILENO);
+  posix_spawn_file_actions_addclose(&actions, out_pipe[0]);
+  posix_spawn_file_actions_addclose(&actions, out_pipe[1]);
+  posix_spawn_file_actions_addopen(&actions, STDERR_FILENO, "/dev/null",
+                                   O_WRONLY, 0);
+
+  std::string program_str = program.string();
+  std::vector<char *> argv;
+  argv.push_back(program_str.data());
+  std::vector<std::string> args_copy = args;
+  for (auto &arg : args_copy) {
+    argv.push_back(arg.data());
+  }
+  argv.push_back(nullptr);
+  std::vector<std::string> env_copy = env;
+  std::vector<char *> envp;
+  for (auto &var : env_copy) {
+    envp.push_back(var.data());
+  }
+  envp.push_back(nullptr);
+
+  auto start = std::chrono::steady_clock::now();
+  pid_t pid = 0;
+  int spawn_error = posix_spawn(&pid, program_str.c_str(), &actions, nullptr,
+                                argv.data(), envp.data());
+  posix_spawn_file_actions_destroy(&actions);
+  ::close(out_pipe[1]);
+  if (spawn_error != 0) {
+    ::close(out_pipe[0]);
+    return std::unexpected(std::format("cannot spawn {}", program_str));
+  }
+
+  RunResult result{};
+  char buffer[4096];
+  ssize_t got = 0;
+  while ((got = ::read(out_pipe[0], buffer, sizeof(buffer))) > 0) {
+    result.output.append(buffer, static_cast<size_t>(got));
+  }
+  ::close(out_pipe[0]);
+
+  int status = 0;
+  struct rusage usage {};
+  if (::wait4(pid, &status, 0, &usage) < 0) {
+    return std::unexpected("wait4() failed");
+  }
+  result.wall_ms = std::chrono::duration<double, std::milli>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+  result.max_rss_kb = usage.ru_maxrss;
+
+  if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+    return std::unexpected(std::format("exit status {}", status));
+  }
+  return result;
+}
+
+// Every expected answer has to appear as a number somewhere in the output;
+// days print their answers in different orders and with different labels.
+std::vector<std::string> missingAnswers(const TargetSpec &spec,
+                                        std::string_view output) {
+  std::vector<std::string_view> numbers;
+  size_t pos = 0;
+  while ((pos = pc::find_digit(output, pos)) != std::string_view::npos) {
+    size_t end = std::min(pc::find_non_digit(output, pos), output.size());
+    numbers.push_back(output.substr(pos, end - pos));
+    pos = end;
+  }
+  std::vector<std::string> missing;
+  for (const auto &answer : spec.expected) {
+    if (std::ranges::find(numbers, answer) == numbers.end()) {
+      missing.push_back(answer);
+    }
+  }
+  return missing;
+}
+
+double percentile(std::vector<double> sorted, double fraction) {
+  if (sorted.empty()) {
+    return 0.0;
+  }
+  std::ranges::sort(sorted);
+  auto rank = static_cast<size_t>(
+      std::ceil(fraction * static_cast<double>(sorted.size())));
+  return sorted[std::clamp<size_t>(rank, 1, sorted.size()) - 1];
+}
+
+std::string jsonEscape(std::string_view text) {
+  std::string escaped;
+  for (char c : text) {
+    if (c == '"' || c == '\\') {
+      escaped.push_back('\\');
+      escaped.push_back(c);
+    } else if (static_cast<unsigned char>(c) < 0x20) {
+      escaped += std::format("\\u{:04x}", static_cast<int>(c));
+    } else {
+      escaped.push_back(c);
+    }
+  }
+  return escaped;
+}
+
+// Cold runs wipe the cache directory first, the warm ones then reuse the
+// cache file written by the last cold run
+std::expected<void, std::string>
+measureCache(const std::filesystem::path &program,
+             const std::vector<std::string> &args,
+             const std::filesystem::path &cache_dir, int runs,
+             TargetReport &report) {
+  const auto env = childEnvironment(
+      {std::format("{}={}", CacheDirVariable, cache_dir.string())});
+  for (int i = 0; i < runs; ++i) {
+    std::error_code ec;
+    std::filesystem::remove_all(cache_dir, ec);
+    auto result = runOnce(program, args, env);
+    if (!result) {
+      return std::unexpected(result.error());
+    }
+    report.cold_ms.push_back(result->wall_ms);
+  }
+  for (int i = 0; i < runs; ++i) {
+    auto result = runOnce(program, args, env);
+    if (!result) {
+      return std::unexpected(result.error());
+    }
+    report.warm_ms.push_back(result->wall_ms);
+  }
+  return {};
+}
+
+std::vector<std::string_view> splitFields(std::string_view line) {
+  std::vector<std::string_view> fields;
+  for (size_t begin = 0; begin <= line.size();) {
+    size_t end = std::min(line.find('\t', begin), line.size());
+    fields.push_back(line.substr(begin, end - begin));
+    begin = end + 1;
+  }
+  return fields;
+}
+
+// One run with `variable` naming a file the puzzle writes its phase report
+// to at exit; the lines of that file, or nullopt when the puzzle was built
+// without the instrumentation and wrote nothing
+std::expected<std::optional<std::vector<std::string>>, std::string>
+runWithPhaseReport(const std::filesystem::path &program,
+                   const std::vector<std::string> &args,
+                   std::string_view variable, const TargetReport &report) {
+  auto file = std::filesystem::temp_directory_path() /
+              std::format("bench_{}_{}_{}.tsv", ::getpid(), report.name,
+                          variable);
+  std::error_code ec;
+  std::filesystem::remove(file, ec);
+  auto result = runOnce(
+      program, args,
+      childEnvironment({std::format("{}={}", variable, file.string())}));
+  if (!result) {
+    return std::unexpected(result.error());
+  }
+  if (!std::filesystem::exists(file)) {
+    return std::nullopt;
+  }
+  auto lines = pc::readFileByLine<std::vector<std::string>>(
+      file, [](std::string_view line, std::vector<std::string> &lines) {
+        lines.emplace_back(line);
+        return true;
+      });
+  std::filesystem::remove(file, ec);
+  if (!lines) {
+    return std::unexpected(std::format("cannot read {}", file.string()));
+  }
+  return std::move(*lines);
+}
+
+// Lines "phase <name> <calls> <wall ms> <counter>..." from
+// $PUZZLES_PERF_FILE; "-" marks an unavailable counter
+std::expected<void, std::string>
+measurePhases(const std::filesystem::path &program,
+              const std::vector<std::string> &args, TargetReport &report) {
+  auto lines = runWithPhaseReport(program, args, PerfFileVariable, report);
+  if (!lines) {
+    return std::unexpected(lines.error());
+  }
+  if (!*lines) {
+    report.perf_note = "no counters, build with -DPUZZLES_PERF_COUNTERS=ON";
+    return {};
+  }
+  for (std::string_view line : **lines) {
+    if (line.starts_with("# counters unavailable: ")) {
+      report.perf_note = line.substr(2);
+    }
+    if (!line.starts_with("phase\t")) {
+      continue;
+    }
+    auto fields = splitFields(line);
+    auto calls = pc::to_unsigned<uint64_t>(
+        fields.size() > 2 ? fields[2] : std::string_view{});
+    if (fields.size() != 4 + PerfCounterNames.size() || !calls) {
+      return std::unexpected(std::format("malformed perf line: {}", line));
+    }
+    PhaseReport phase{};
+    phase.name = fields[1];
+    phase.calls = *calls;
+    phase.wall_ms = std::stod(std::string(fields[3]));
+    for (auto field : std::span(fields).subspan(4)) {
+      auto value = pc::to_unsigned<uint64_t>(field);
+      phase.counters.push_back(value ? std::optional<uint64_t>(*value)
+                                     : std::nullopt);
+    }
+    report.phases.push_back(std::move(phase));
+  }
+  return {};
+}
+
+// The "allocations: N (B bytes, peak P live)" line and the lines
+// "phase <name> <calls> <allocations> <bytes> <peak live bytes>" from
+// $PUZZLES_ALLOC_FILE
+std::expected<void, std::string>
+measureAllocations(const std::filesystem::path &program,
+                   const std::vector<std::string> &args,
+                   TargetReport &report) {
+  auto lines = runWithPhaseReport(program, args, AllocFileVariable, report);
+  if (!lines) {
+    return std::unexpected(lines.error());
+  }
+  if (!*lines) {
+    report.alloc_note = "no counts, build with -DPUZZLES_COUNT_ALLOCS=ON";
+    return {};
+  }
+  for (std::string_view line : **lines) {
+    if (line.starts_with("allocations: ")) {
+      std::vector<uint64_t> totals;
+      size_t pos = 0;
+      while ((pos = pc::find_digit(line, pos)) != std::string_view::npos) {
+        size_t end = std::min(pc::find_non_digit(line, pos), line.size());
+        totals.push_back(
+            pc::to_unsigned<uint64_t>(line.substr(pos, end - pos)).value());
+        pos = end;
+      }
+      if (totals.size() != 3) {
+        return std::unexpected(std::format("malformed totals: {}", line));
+      }
+      report.allocations =
+          AllocationReport{"total", 1, totals[0], totals[1], totals[2]};
+      continue;
+    }
+    if (!line.starts_with("phase\t")) {
+      continue;
+    }
+    auto fields = splitFields(line);
+    std::vector<uint64_t> values;
+    for (auto field : std::span(fields).subspan(std::min<size_t>(
+             2, fields.size()))) {
+      if (auto value = pc::to_unsigned<uint64_t>(field)) {
+        values.push_back(*value);
+      }
+    }
+    if (fields.size() != 6 || values.size() != 4) {
+      return std::unexpected(std::format("malformed phase line: {}", line));
+    }
+    report.alloc_phases.push_back(AllocationReport{
+        std::string(fields[1]), values[0], values[1], values[2], values[3]});
+  }
+  return {};
+}
+
+std::string formatCounter(const std::optional<uint64_t> &counter) {
+  return counter ? std::to_string(*counter) : "-";
+}
+
+// Instructions per cycle, when both counters are there
+std::string formatIpc(const PhaseReport &phase) {
+  const auto &cycles = phase.counters[0];
+  const auto &instructions = phase.counters[1];
+  if (!cycles || !instructions || *cycles == 0) {
+    return "-";
+  }
+  return std::format("{:.2f}", static_cast<double>(*instructions) /
+                                   static_cast<double>(*cycles));
+}
+
+bool writeReport(const std::filesystem::path &file,
+                 const std::vector<TargetReport> &reports, int runs,
+                 int warmups) {
+  std::FILE *out = std::fopen(file.c_str(), "w");
+  if (!out) {
+    return false;
+  }
+  std::println(out, "{{");
+  std::println(out, "  \"runs\": {},", runs);
+  std::println(out, "  \"warmups\": {},", warmups);
+  std::println(out, "  \"targets\": [");
+  for (size_t i = 0; i < reports.size(); ++i) {
+    const auto &report = reports[i];
+    std::string times;
+    for (size_t t = 0; t < report.times_ms.size(); ++t) {
+      times += std::format("{}{:.3f}", t ? ", " : "", report.times_ms[t]);
+    }
+    std::println(out, "    {{");
+    std::println(out, "      \"name\": \"{}\",", report.name);
+    std::println(out, "      \"status\": \"{}\",", report.status);
+    std::println(out, "      \"detail\": \"{}\",", jsonEscape(report.detail));
+    std::println(out, "      \"min_ms\": {:.3f},",
+                 percentile(report.times_ms, 0.0));
+    std::println(out, "      \"median_ms\": {:.3f},",
+                 percentile(report.times_ms, 0.5));
+    std::println(out, "      \"p99_ms\": {:.3f},",
+                 percentile(report.times_ms, 0.99));
+    std::println(out, "      \"max_rss_kb\": {},", report.max_rss_kb);
+    std::println(out, "      \"budget_ms\": {:.3f},", report.budget_ms);
+    std::println(out, "      \"over_budget\": {},", report.over_budget);
+    if (!report.cold_ms.empty()) {
+      std::println(out, "      \"cache_cold_median_ms\": {:.3f},",
+                   percentile(report.cold_ms, 0.5));
+      std::println(out, "      \"cache_warm_median_ms\": {:.3f},",
+                   percentile(report.warm_ms, 0.5));
+    }
+    if (!report.phases.empty() || !report.perf_note.empty()) {
+      std::println(out, "      \"perf_note\": \"{}\",",
+                   jsonEscape(report.perf_note));
+      std::println(out, "      \"phases\": [");
+      for (size_t p = 0; p < report.phases.size(); ++p) {
+        const auto &phase = report.phases[p];
+        std::print(out,
+                   "        {{\"name\": \"{}\", \"calls\": {}, "
+                   "\"wall_ms\": {:.3f}",
+                   jsonEscape(phase.name), phase.calls, phase.wall_ms);
+        for (size_t c = 0; c < PerfCounterNames.size(); ++c) {
+          // JSON null for an unavailable counter
+          std::print(out, ", \"{}\": {}", PerfCounterNames[c],
+                     phase.counters[c] ? formatCounter(phase.counters[c])
+                                       : "null");
+        }
+        std::println(out, "}}{}", p + 1 < report.phases.size() ? "," : "");
+      }
+      std::println(out, "      ],");
+    }
+    if (report.allocations || !report.alloc_note.empty()) {
+      std::println(out, "      \"alloc_note\": \"{}\",",
+                   jsonEscape(report.alloc_note));
+      if (report.allocations) {
+        std::println(out, "      \"allocations\": {},",
+                     report.allocations->allocations);
+        std::println(out, "      \"allocated_bytes\": {},",
+                     report.allocations->bytes);
+        std::println(out, "      \"peak_live_bytes\": {},",
+                     report.allocations->peak_live_bytes);
+      }
+      std::println(out, "      \"alloc_phases\": [");
+      for (size_t p = 0; p < report.alloc_phases.size(); ++p) {
+        const auto &phase = report.alloc_phases[p];
+        std::println(out,
+                     "        {{\"name\": \"{}\", \"calls\": {}, "
+                     "\"allocations\": {}, \"bytes\": {}, "
+                     "\"peak_live_bytes\": {}}}{}",
+                     jsonEscape(phase.name), phase.calls, phase.allocations,
+                     phase.bytes, phase.peak_live_bytes,
+                     p + 1 < report.alloc_phases.size() ? "," : "");
+      }
+      std::println(out, "      ],");
+    }
+    std::println(out, "      \"times_ms\": [{}]", times);
+    std::println(out, "    }}{}", i + 1 < reports.size() ? "," : "");
+  }
+  std::println(out, "  ]");
+  std::println(out, "}}");
+  std::fclose(out);
+  return true;
+}
+} // namespace
+
+int main(int argc, char *argv[]) {
+  std::filesystem::path config_file;
+  std::filesystem::path source_dir = ".";
+  std::filesystem::path report_file = "bench_report.json";
+  std::map<std::string, std::filesystem::path> programs;
+  int runs = 10;
+  int warmups = 2;
+  bool check_budgets = false;
+  bool perf = false;
+  bool allocs = false;
+  std::filesystem::path cache_dir;
+
+  for (int i = 1; i < argc; ++i) {
+    std::string_view arg = argv[i];
+    bool has_value = i + 1 < argc;
+    if (arg == "--config" && has_value) {
+      config_file = argv[++i];
+    } else if (arg == "--source-dir" && has_value) {
+      source_dir = argv[++i];
+    } else if (arg == "--report" && has_value) {
+      report_file = argv[++i];
+    } else if (arg == "--runs" && has_value) {
+      runs = std::max(1, std::stoi(argv[++i]));
+    } else if (arg == "--warmups" && has_value) {
+      warmups = std::max(0, std::stoi(argv[++i]));
+    } else if (arg == "--target" && has_value) {
+      std::string_view target = argv[++i];
+      auto eq = target.find('=');
+      if (eq == std::string_view::npos) {
+        std::println(stderr, "Expected --target name=path, got {}", target);
+        return 1;
+      }
+      programs[std::string(target.substr(0, eq))] = target.substr(eq + 1);
+    } else if (arg == "--cache-dir" && has_value) {
+      cache_dir = argv[++i];
+    } else if (arg == "--perf") {
+      perf = true;
+    } else if (arg == "--allocs") {
+      allocs = true;
+    } else if (arg == "--check-budgets") {
+      check_budgets = true;
+    } else {
+      std::println(stderr, "Unknown argument: {}", arg);
+      return 1;
+    }
+  }
+
+  auto specs = readConfig(config_file);
+  if (!specs) {
+    std::println(stderr, pc::InputFileError);
+    return 1;
+  }
+
+  std::println("{:<16} {:>6} {:>10} {:>10} {:>10} {:>10} {:>10}  {}",
+               "target", "runs", "min ms", "median ms", "p99 ms", "budget",
+               "rss KiB", "status");
+
+  bool failed = false;
+  std::vector<TargetReport> reports;
+  for (const auto &spec : *specs) {
+    TargetReport report{};
+    report.name = spec.name;
+    report.budget_ms = spec.budget_ms;
+
+    auto program = programs.find(spec.name);
+    if (program == programs.end() ||
+        !std::filesystem::exists(program->second)) {
+      report.status = "missing";
+      std::println("{:<16} {:>6} {:>10} {:>10} {:>10} {:>10} {:>10}  {}",
+                   spec.name, 0, "-", "-", "-", spec.budget_ms, "-",
+                   report.status);
+      reports.push_back(std::move(report));
+      continue;
+    }
+
+    std::vector<std::string> args;
+    for (const auto &arg : spec.args) {
+      auto in_source = source_dir / arg;
+      args.push_back(std::filesystem::exists(in_source) ? in_source.string()
+                                                        : arg);
+    }
+
+    const int target_runs = spec.runs > 0 ? spec.runs : runs;
+    const int target_warmups = spec.runs > 0 ? 0 : warmups;
+    report.status = "ok";
+    const auto plain_env = childEnvironment();
+    for (int i = 0; i < target_warmups + target_runs; ++i) {
+      auto result = runOnce(program->second, args, plain_env);
+      if (!result) {
+        report.status = "failed";
+        report.detail = result.error();
+        break;
+      }
+      if (i == 0) {
+        auto missing = missingAnswers(spec, result->output);
+        if (!missing.empty()) {
+          report.status = "mismatch";
+          for (const auto &answer : missing) {
+            report.detail += (report.detail.empty() ? "missing " : ", ") +
+                             answer;
+          }
+        }
+      }
+      if (i >= target_warmups) {
+        report.times_ms.push_back(result->wall_ms);
+        report.max_rss_kb = std::max(report.max_rss_kb, result->max_rss_kb);
+      }
+    }
+
+    if (!cache_dir.empty() && report.status == "ok") {
+      auto cached = measureCache(program->second, args, cache_dir / spec.name,
+                                 target_runs, report);
+      if (!cached) {
+        report.status = "failed";
+        report.detail = "cache: " + cached.error();
+      }
+    }
+
+    if (perf && report.status == "ok") {
+      auto phases = measurePhases(program->second, args, report);
+      if (!phases) {
+        report.status = "failed";
+        report.detail = "perf: " + phases.error();
+      }
+    }
+    if (allocs && report.status == "ok") {
+      auto counted = measureAllocations(program->second, args, report);
+      if (!counted) {
+        report.status = "failed";
+        report.detail = "allocs: " + counted.error();
+      }
+    }
+
+    const double median = percentile(report.times_ms, 0.5);
+    report.over_budget = report.status == "ok" && median > spec.budget_ms;
+    if (report.status != "ok" || (check_budgets && report.over_budget)) {
+      failed = true;
+    }
+    std::println("{:<16} {:>6} {:>10.2f} {:>10.2f} {:>10.2f} {:>10} {:>10}  "
+                 "{}{}{}",
+                 spec.name, report.times_ms.size(),
+                 percentile(report.times_ms, 0.0), median,
+                 percentile(report.times_ms, 0.99), spec.budget_ms,
+                 report.max_rss_kb, report.status,
+                 report.over_budget ? " (over budget)" : "",
+                 report.detail.empty() ? "" : ": " + report.detail);
+    if (!report.cold_ms.empty()) {
+      std::println("{:<16} cache cold median {:.2f} ms, warm median {:.2f} ms",
+                   "", percentile(report.cold_ms, 0.5),
+                   percentile(report.warm_ms, 0.5));
+    }
+    if (!report.perf_note.empty()) {
+      std::println("{:<16} perf: {}", "", report.perf_note);
+    }
+    if (!report.phases.empty()) {
+      std::println("{:<16} {:<26} {:>6} {:>10} {:>14} {:>14} {:>5} {:>12} "
+                   "{:>12} {:>12}",
+                   "", "phase", "calls", "wall ms", "cycles", "instructions",
+                   "IPC", "cache-miss", "branch-miss", "dtlb-miss");
+    }
+    for (const auto &phase : report.phases) {
+      std::println("{:<16} {:<26} {:>6} {:>10.2f} {:>14} {:>14} {:>5} {:>12} "
+                   "{:>12} {:>12}",
+                   "", phase.name, phase.calls, phase.wall_ms,
+                   formatCounter(phase.counters[0]),
+                   formatCounter(phase.counters[1]), formatIpc(phase),
+                   formatCounter(phase.counters[2]),
+                   formatCounter(phase.counters[3]),
+                   formatCounter(phase.counters[4]));
+    }
+    if (!report.alloc_note.empty()) {
+      std::println("{:<16} allocs: {}", "", report.alloc_note);
+    }
+    if (report.allocations) {
+      std::println("{:<16} allocations {} ({} bytes, peak {} live)", "",
+                   report.allocations->allocations, report.allocations->bytes,
+                   report.allocations->peak_live_bytes);
+    }
+    if (!report.alloc_phases.empty()) {
+      std::println("{:<16} {:<26} {:>6} {:>12} {:>14} {:>14}", "", "phase",
+                   "calls", "allocations", "bytes", "peak live");
+    }
+    for (const auto &phase : report.alloc_phases) {
+      std::println("{:<16} {:<26} {:>6} {:>12} {:>14} {:>14}", "", phase.name,
+                   phase.calls, phase.allocations, phase.bytes,
+                   phase.peak_live_bytes);
+    }
+    reports.push_back(std::move(report));
+  }
+
+  if (!writeReport(report_file, reports, runs, warmups)) {
+    std::println(stderr, "Cannot write report {}", report_file.string());
+    return 1;
+  }
+  std::println("Report written to {}", report_file.string());
+  return failed ? 1 : 0;
+}
@@ -0,0 +1,139 @@
+/*
+ * Reader benchmark
+ * Times the line readers from common.h over every day's input:
+ *   function - readFileByLine with a type-erased std::function (before)
+ *   visitor  - readFileByLine with the visitor inlined into the loop (after)
+ *   mapped   - readFileByLineMapped, string_views into the mapped file
+ *   batch    - readFileByBatch, one call per chunk of lines
+ * followed by the parse_integers throughput over the integer record days.
+ * Usage: reader_bench [repetitions] [source dir]
+ */
+
+#include "../common/common.h"
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <print>
+#include <string>
+#include <vector>
+
+namespace {
+namespace pc = puzzles::common;
+
+struct LineStats {
+  size_t lines = 0;
+  size_t bytes = 0;
+};
+
+bool countLine(std::string_view line, LineStats &stats) {
+  ++stats.lines;
+  stats.bytes += line.size();
+  return true;
+}
+
+// Best time of `repetitions` runs, in nanoseconds per line
+template <typename Reader>
+double bestNsPerLine(int repetitions, Reader &&reader) {
+  double best = 0.0;
+  for (int i = 0; i < repetitions; ++i) {
+    auto start = std::chrono::steady_clock::now();
+    auto result = reader();
+    auto elapsed = std::chrono::duration<double, std::nano>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+    if (!result || result->lines == 0) {
+      return -1.0;
+    }
+    double per_line = elapsed / static_cast<double>(result->lines);
+    best = (i == 0) ? per_line : std::min(best, per_line);
+  }
+  return best;
+}
+} // namespace
+
+int main(int argc, char *argv[]) {
+  const int repetitions = (argc > 1) ? std::stoi(argv[1]) : 50;
+  const std::filesystem::path source_dir = (argc > 2) ? argv[2] : SOURCE_DIR;
+
+  std::println("{:<6} {:>8} {:>10} {:>10} {:>10} {:>10} {:>8}", "day",
+               "lines", "function", "visitor", "mapped", "batch", "speedup");
+
+  for (int day = 1; day <= 12; ++day) {
+    const auto input =
+        source_dir / ("Day" + std::to_string(day)) / "input";
+
+    const std::function<bool(std::string_view, LineStats &)> erased =
+        countLine;
+    auto function_ns = bestNsPerLine(repetitions, [&] {
+      return pc::readFileByLine<LineStats>(input, erased);
+    });
+    auto visitor_ns = bestNsPerLine(repetitions, [&] {
+      return pc::readFileByLine<LineStats>(
+          input, [](std::string_view line, LineStats &stats) {
+            return countLine(line, stats);
+          });
+    });
+    auto mapped_ns = bestNsPerLine(repetitions, [&] {
+      return pc::readFileByLineMapped<LineStats>(
+          input, [](std::string_view line, LineStats &stats) {
+            return countLine(line, stats);
+          });
+    });
+    auto batch_ns = bestNsPerLine(repetitions, [&] {
+      return pc::readFileByBatch<LineStats>(
+          input,
+          [](std::span<const std::string_view> lines, LineStats &stats) {
+            stats.lines += lines.size();
+            for (auto line : lines) {
+              stats.bytes += line.size();
+            }
+            return true;
+          });
+    });
+
+    if (function_ns < 0 || visitor_ns < 0 || mapped_ns < 0 || batch_ns < 0) {
+      std::println(stderr, "Day{}: {}", day, pc::InputFileError);
+      return 1;
+    }
+
+    auto lines = pc::readFileByLineMapped<LineStats>(
+                     input, [](std::string_view line, LineStats &stats) {
+                       return countLine(line, stats);
+                     })
+                     ->lines;
+    std::println("Day{:<3} {:>8} {:>10.1f} {:>10.1f} {:>10.1f} {:>10.1f} "
+                 "{:>7.1f}x",
+                 day, lines, function_ns, visitor_ns, mapped_ns, batch_ns,
+                 function_ns / std::min({visitor_ns, mapped_ns, batch_ns}));
+  }
+  std::println("(ns per line, best of {} runs)", repetitions);
+
+  for (int day : {2, 5, 8, 9}) {
+    const auto input =
+        source_dir / ("Day" + std::to_string(day)) / "input";
+    auto file = pc::MappedFile::open(input);
+    if (!file) {
+      std::println(stderr, "Day{}: {}", day, pc::InputFileError);
+      return 1;
+    }
+    std::array<uint64_t, 256> fields{};
+    double best = 0.0;
+    size_t total = 0;
+    for (int i = 0; i < repetitions; ++i) {
+      total = 0;
+      auto start = std::chrono::steady_clock::now();
+      pc::forEachLine(file->view(), [&](std::string_view line) {
+        auto parsed = pc::parse_integers(line, std::span(fields));
+        total += parsed ? *parsed : 0;
+        return true;
+      });
+      auto seconds = std::chrono::duration<double>(
+                         std::chrono::steady_clock::now() - start)
+                         .count();
+      best = (i == 0) ? seconds : std::min(best, seconds);
+    }
+    std::println("Day{:<3} parse_integers: {} fields, {:.1f} MB/s", day,
+                 total, static_cast<double>(file->size()) / best / 1e6);
+  }
+  return 0;
+}
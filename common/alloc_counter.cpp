@@ -0,0 +1,201 @@
+/*
+ * Global operator new/delete replacement that counts every heap allocation
+ * made through C++ allocation functions (containers, strings, iostreams).
+ * Linked into the executables only with -DPUZZLES_COUNT_ALLOCS=ON.
+ * Each block carries its size in a small header in front of it, so frees
+ * can be subtracted from the live bytes exactly.
+ */
+
+#include "alloc_counter.h"
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <new>
+#include <vector>
+
+namespace {
+namespace pc = puzzles::common;
+
+std::atomic<uint64_t> allocation_count{0};
+std::atomic<uint64_t> allocated_bytes{0};
+std::atomic<int64_t> live_bytes{0};
+std::atomic<int64_t> peak_live_bytes{0};
+
+// Counters of the calling thread; constant initialised, so they are safe to
+// touch from operator new at any point of a thread's life
+struct ThreadHeap {
+  uint64_t allocations;
+  uint64_t bytes;
+  int64_t live_bytes; // negative when it freed other threads' blocks
+  int64_t peak_live_bytes;
+};
+thread_local ThreadHeap thread_heap{};
+
+constexpr std::size_t HeaderSize = alignof(std::max_align_t);
+
+std::size_t headerSize(std::size_t alignment) {
+  return std::max(alignment, HeaderSize);
+}
+
+void *countedAlloc(std::size_t size, std::size_t alignment) {
+  const std::size_t offset = headerSize(alignment);
+  void *base = alignment > HeaderSize
+                   ? std::aligned_alloc(alignment,
+                                        (size + offset + alignment - 1) /
+                                            alignment * alignment)
+                   : std::malloc(size + offset);
+  if (!base) {
+    throw std::bad_alloc();
+  }
+  auto *ptr = static_cast<char *>(base) + offset;
+  std::memcpy(ptr - sizeof(size), &size, sizeof(size));
+
+  allocation_count.fetch_add(1, std::memory_order_relaxed);
+  allocated_bytes.fetch_add(size, std::memory_order_relaxed);
+  const auto signed_size = static_cast<int64_t>(size);
+  int64_t live =
+      live_bytes.fetch_add(signed_size, std::memory_order_relaxed) +
+      signed_size;
+  int64_t peak = peak_live_bytes.load(std::memory_order_relaxed);
+  while (live > peak && !peak_live_bytes.compare_exchange_weak(
+                            peak, live, std::memory_order_relaxed)) {
+  }
+
+  auto &heap = thread_heap;
+  ++heap.allocations;
+  heap.bytes += size;
+  heap.live_bytes += signed_size;
+  heap.peak_live_bytes = std::max(heap.peak_live_bytes, heap.live_bytes);
+  return ptr;
+}
+
+void countedFree(void *ptr, std::size_t alignment) {
+  if (!ptr) {
+    return;
+  }
+  auto *block = static_cast<char *>(ptr);
+  std::size_t size;
+  std::memcpy(&size, block - sizeof(size), sizeof(size));
+  live_bytes.fetch_sub(static_cast<int64_t>(size), std::memory_order_relaxed);
+  thread_heap.live_bytes -= static_cast<int64_t>(size);
+  std::free(block - headerSize(alignment));
+}
+
+struct PhaseAllocations {
+  std::string_view name;
+  uint64_t calls;
+  pc::AllocationStats stats; // peak is the largest of any call
+};
+
+// Constant initialised as well, so phases can be recorded before this file's
+// dynamic initialisation and until the report below has been written
+std::mutex phases_mutex;
+std::vector<PhaseAllocations> phases;
+
+// Prints the totals once static destruction starts, after main returned
+struct ExitReport {
+  ~ExitReport() {
+    const char *path = std::getenv("PUZZLES_ALLOC_FILE");
+    std::FILE *out = path && *path ? std::fopen(path, "w") : stderr;
+    if (!out) {
+      std::fprintf(stderr, "Cannot write allocation file %s\n", path);
+      return;
+    }
+    std::fprintf(out, "allocations: %llu (%llu bytes, peak %llu live)\n",
+                 static_cast<unsigned long long>(allocation_count.load()),
+                 static_cast<unsigned long long>(allocated_bytes.load()),
+                 static_cast<unsigned long long>(peak_live_bytes.load()));
+    std::lock_guard lock(phases_mutex);
+    if (!phases.empty()) {
+      std::fprintf(out, "# phase\tname\tcalls\tallocations\tbytes\t"
+                        "peak_live_bytes\n");
+    }
+    for (const auto &phase : phases) {
+      std::fprintf(out, "phase\t%.*s\t%llu\t%llu\t%llu\t%llu\n",
+                   static_cast<int>(phase.name.size()), phase.name.data(),
+                   static_cast<unsigned long long>(phase.calls),
+                   static_cast<unsigned long long>(phase.stats.allocations),
+                   static_cast<unsigned long long>(phase.stats.bytes),
+                   static_cast<unsigned long long>(
+                       phase.stats.peak_live_bytes));
+    }
+    if (out != stderr) {
+      std::fclose(out);
+    }
+  }
+} exit_report;
+} // namespace
+
+namespace puzzles::common {
+AllocationStats allocationStats() {
+  return {allocation_count.load(std::memory_order_relaxed),
+          allocated_bytes.load(std::memory_order_relaxed),
+          static_cast<uint64_t>(
+              peak_live_bytes.load(std::memory_order_relaxed))};
+}
+
+AllocationMark beginAllocationPhase() {
+  auto &heap = thread_heap;
+  AllocationMark mark{heap.allocations, heap.bytes, heap.live_bytes,
+                      heap.peak_live_bytes};
+  heap.peak_live_bytes = heap.live_bytes;
+  return mark;
+}
+
+AllocationStats endAllocationPhase(std::string_view name,
+                                   const AllocationMark &mark) {
+  auto &heap = thread_heap;
+  AllocationStats stats{
+      heap.allocations - mark.allocations, heap.bytes - mark.bytes,
+      static_cast<uint64_t>(
+          std::max<int64_t>(0, heap.peak_live_bytes - mark.live_bytes))};
+  // An enclosing phase still sees this phase's peak
+  heap.peak_live_bytes = std::max(heap.peak_live_bytes, mark.peak_live_bytes);
+
+  std::lock_guard lock(phases_mutex);
+  auto it = std::ranges::find(phases, name, &PhaseAllocations::name);
+  if (it == phases.end()) {
+    it = phases.insert(phases.end(), PhaseAllocations{name, 0, {}});
+  }
+  ++it->calls;
+  it->stats.allocations += stats.allocations;
+  it->stats.bytes += stats.bytes;
+  it->stats.peak_live_bytes =
+      std::max(it->stats.peak_live_bytes, stats.peak_live_bytes);
+  return stats;
+}
+} // namespace puzzles::common
+
+void *operator new(std::size_t size) { return countedAlloc(size, 0); }
+void *operator new[](std::size_t size) { return countedAlloc(size, 0); }
+void *operator new(std::size_t size, std::align_val_t alignment) {
+  return countedAlloc(size, static_cast<std::size_t>(alignment));
+}
+void *operator new[](std::size_t size, std::align_val_t alignment) {
+  return countedAlloc(size, static_cast<std::size_t>(alignment));
+}
+
+void operator delete(void *ptr) noexcept { countedFree(ptr, 0); }
+void operator delete[](void *ptr) noexcept { countedFree(ptr, 0); }
+void operator delete(void *ptr, std::size_t) noexcept { countedFree(ptr, 0); }
+void operator delete[](void *ptr, std::size_t) noexcept {
+  countedFree(ptr, 0);
+}
+void operator delete(void *ptr, std::align_val_t alignment) noexcept {
+  countedFree(ptr, static_cast<std::size_t>(alignment));
+}
+void operator delete[](void *ptr, std::align_val_t alignment) noexcept {
+  countedFree(ptr, static_cast<std::size_t>(alignment));
+}
+void operator delete(void *ptr, std::size_t,
+                     std::align_val_t alignment) noexcept {
+  countedFree(ptr, static_cast<std::size_t>(alignment));
+}
+void operator delete[](void *ptr, std::size_t,
+                       std::align_val_t alignment) noexcept {
+  countedFree(ptr, static_cast<std::size_t>(alignment));
+}
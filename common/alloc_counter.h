@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+
+// Process wide heap allocation counter. Configure with
+// -DPUZZLES_COUNT_ALLOCS=ON to link common/alloc_counter.cpp, which replaces
+// the global operator new/delete and prints the totals to stderr at exit.
+// Every PUZZLES_TRACE_SCOPE then also counts the allocations, bytes and peak
+// live bytes of its phase; the totals per phase name are written at exit to
+// $PUZZLES_ALLOC_FILE, or stderr when it is unset.
+
+namespace puzzles::common {
+
+struct AllocationStats {
+  uint64_t allocations = 0;
+  uint64_t bytes = 0;
+  uint64_t peak_live_bytes = 0;
+};
+
+// Heap state of one thread when a phase started
+struct AllocationMark {
+  uint64_t allocations = 0;
+  uint64_t bytes = 0;
+  int64_t live_bytes = 0;
+  int64_t peak_live_bytes = 0;
+};
+
+#ifdef PUZZLES_COUNT_ALLOCS
+// Totals since process start; the peak is of the whole process
+AllocationStats allocationStats();
+
+// Starts a phase on the calling thread. Phases nest but have to end on the
+// thread that started them, in reverse order.
+AllocationMark beginAllocationPhase();
+// Adds what the calling thread allocated since `mark` to the totals of
+// `name`, which has to outlive the process. The peak is the growth of the
+// bytes this thread allocated and has not freed itself, so blocks handed to
+// another thread to free still count.
+AllocationStats endAllocationPhase(std::string_view name,
+                                   const AllocationMark &mark);
+
+// Counts [construction, end()) as one call of a phase
+class AllocationScope {
+public:
+  explicit AllocationScope(std::string_view name)
+      : name_(name), mark_(beginAllocationPhase()) {}
+  AllocationScope(const AllocationScope &) = delete;
+  AllocationScope &operator=(const AllocationScope &) = delete;
+  ~AllocationScope() { end(); }
+
+  void end() {
+    if (!ended_) {
+      ended_ = true;
+      endAllocationPhase(name_, mark_);
+    }
+  }
+
+private:
+  std::string_view name_;
+  AllocationMark mark_;
+  bool ended_ = false;
+};
+#else
+inline AllocationStats allocationStats() { return {}; }
+#endif
+
+} // namespace puzzles::common
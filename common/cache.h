@@ -0,0 +1,324 @@
+#pragma once
+
+// Binary cache of parsed inputs. A day stores its parsed structure as a few
+// arrays of trivially copyable records; the file is keyed by a hash of the
+// input content and mapped straight back on the next run, so a warm start
+// does no text parsing at all.
+//
+// Caching is off unless $PUZZLES_CACHE_DIR names a directory. Files are
+// machine local: records are stored in native layout and byte order, and
+// every section records its element size so a layout change is noticed.
+
+#include "common.h"
+#include <bit>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <expected>
+#include <filesystem>
+#include <format>
+#include <optional>
+#include <print>
+#include <span>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+namespace puzzles::common {
+
+// Bump when the header or section table layout changes; per-day layouts are
+// versioned separately by the schema passed to cachedInput
+constexpr uint32_t CacheFormatVersion = 1;
+constexpr size_t CacheAlignment = 64;
+
+// 64-bit content hash, one multiply per 8 bytes. Good enough to tell inputs
+// apart, not meant to resist anyone crafting collisions.
+inline uint64_t hashBytes(std::string_view data) {
+  constexpr uint64_t Multiplier = 0x9e3779b97f4a7c15ULL;
+  uint64_t hash = data.size() * Multiplier;
+  size_t pos = 0;
+  for (; pos + 8 <= data.size(); pos += 8) {
+    uint64_t word;
+    std::memcpy(&word, data.data() + pos, 8);
+    hash = std::rotl((hash ^ word) * Multiplier, 31);
+  }
+  uint64_t tail = 0;
+  if (pos < data.size()) {
+    std::memcpy(&tail, data.data() + pos, data.size() - pos);
+  }
+  hash = (hash ^ tail) * Multiplier;
+  return hash ^ (hash >> 32);
+}
+
+struct CacheKey {
+  std::string_view day; // one cache per input format, shared by its parts
+  uint32_t schema;      // the day's record layout version
+  uint64_t input_hash;
+  uint64_t input_size;
+};
+
+struct CacheHeader {
+  char magic[8];
+  uint32_t format_version;
+  uint32_t schema;
+  uint64_t input_hash;
+  uint64_t input_size;
+  uint32_t sections;
+  uint32_t reserved;
+};
+
+struct CacheSection {
+  uint64_t offset; // from the start of the file, CacheAlignment aligned
+  uint64_t count;
+  uint32_t element_size;
+  uint32_t reserved;
+};
+
+inline constexpr char CacheMagic[8] = {'P', 'Z', 'C', 'A', 'C', 'H', 'E', 0};
+
+// Collects the sections of one cache file in memory and writes it out
+class CacheWriter {
+  struct Pending {
+    std::span<const std::byte> bytes;
+    uint64_t count;
+    uint32_t element_size;
+  };
+  std::vector<Pending> sections_;
+
+public:
+  // The data has to stay alive until write()
+  template <typename T> void add(std::span<const T> records) {
+    static_assert(std::is_trivially_copyable_v<T>,
+                  "cached records are copied byte for byte");
+    sections_.push_back(
+        {std::as_bytes(records), records.size(), sizeof(T)});
+  }
+  template <typename T> void add(const std::vector<T> &records) {
+    add(std::span<const T>(records));
+  }
+
+  // Written to a temporary file and renamed, so a concurrent reader sees
+  // either no file or a complete one
+  bool write(const std::filesystem::path &file_name,
+             const CacheKey &key) const {
+    CacheHeader header{};
+    std::memcpy(header.magic, CacheMagic, sizeof(header.magic));
+    header.format_version = CacheFormatVersion;
+    header.schema = key.schema;
+    header.input_hash = key.input_hash;
+    header.input_size = key.input_size;
+    header.sections = static_cast<uint32_t>(sections_.size());
+
+    std::vector<CacheSection> table(sections_.size());
+    uint64_t offset =
+        alignUp(sizeof(header) + table.size() * sizeof(table[0]));
+    for (size_t i = 0; i < sections_.size(); ++i) {
+      table[i] = {offset, sections_[i].count, sections_[i].element_size, 0};
+      offset = alignUp(offset + sections_[i].bytes.size());
+    }
+
+    auto temp_name = file_name;
+    temp_name += std::format(".{}.tmp", tempSuffix());
+    std::FILE *out = std::fopen(temp_name.c_str(), "wb");
+    if (!out) {
+      return false;
+    }
+    bool ok = std::fwrite(&header, sizeof(header), 1, out) == 1 &&
+              (table.empty() || std::fwrite(table.data(), sizeof(table[0]),
+                                            table.size(), out) == table.size());
+    uint64_t written = sizeof(header) + table.size() * sizeof(table[0]);
+    static constexpr std::byte Padding[CacheAlignment]{};
+    for (size_t i = 0; ok && i < sections_.size(); ++i) {
+      size_t padding = table[i].offset - written;
+      const auto &bytes = sections_[i].bytes;
+      ok = std::fwrite(Padding, 1, padding, out) == padding &&
+           std::fwrite(bytes.data(), 1, bytes.size(), out) == bytes.size();
+      written = table[i].offset + bytes.size();
+    }
+    ok = std::fclose(out) == 0 && ok;
+    std::error_code ec;
+    if (ok) {
+      std::filesystem::rename(temp_name, file_name, ec);
+    }
+    if (!ok || ec) {
+      std::filesystem::remove(temp_name, ec);
+      return false;
+    }
+    return true;
+  }
+
+private:
+  static uint64_t alignUp(uint64_t offset) {
+    return (offset + CacheAlignment - 1) / CacheAlignment * CacheAlignment;
+  }
+
+  static unsigned long tempSuffix() {
+#ifdef PUZZLES_HAS_MMAP
+    return static_cast<unsigned long>(::getpid());
+#else
+    return 0;
+#endif
+  }
+};
+
+// Header of a cache file, for files whose key is only known from it; the
+// sections still have to be opened with CacheReader::open and that key
+inline std::expected<CacheHeader, bool>
+readCacheHeader(const std::filesystem::path &file_name) {
+  CacheHeader header;
+  std::FILE *in = std::fopen(file_name.c_str(), "rb");
+  if (!in) {
+    return std::unexpected(false);
+  }
+  bool ok = std::fread(&header, sizeof(header), 1, in) == 1;
+  std::fclose(in);
+  if (!ok ||
+      std::memcmp(header.magic, CacheMagic, sizeof(header.magic)) != 0 ||
+      header.format_version != CacheFormatVersion) {
+    return std::unexpected(false);
+  }
+  return header;
+}
+
+// Mapped cache file; sections are handed out as spans into the mapping
+class CacheReader {
+  MappedFile file_;
+  uint32_t sections_ = 0;
+
+  CacheReader(MappedFile file, uint32_t sections)
+      : file_(std::move(file)), sections_(sections) {}
+
+  // Looked up from the file on every call: a buffered (unmapped) file may
+  // move its data along with the reader
+  std::span<const CacheSection> table() const {
+    return {reinterpret_cast<const CacheSection *>(file_.view().data() +
+                                                   sizeof(CacheHeader)),
+            sections_};
+  }
+
+public:
+  // Fails on a missing file and on any mismatch with the key or the format
+  static std::expected<CacheReader, bool>
+  open(const std::filesystem::path &file_name, const CacheKey &key) {
+    std::error_code ec;
+    if (!std::filesystem::is_regular_file(file_name, ec)) {
+      return std::unexpected(false);
+    }
+    auto file = MappedFile::open(file_name);
+    if (!file || file->size() < sizeof(CacheHeader)) {
+      return std::unexpected(false);
+    }
+    CacheHeader header;
+    std::memcpy(&header, file->view().data(), sizeof(header));
+    if (std::memcmp(header.magic, CacheMagic, sizeof(header.magic)) != 0 ||
+        header.format_version != CacheFormatVersion ||
+        header.schema != key.schema || header.input_hash != key.input_hash ||
+        header.input_size != key.input_size ||
+        file->size() <
+            sizeof(header) + header.sections * sizeof(CacheSection)) {
+      return std::unexpected(false);
+    }
+    CacheReader reader(std::move(*file), header.sections);
+    // Divided rather than multiplied out, so that a damaged entry cannot
+    // wrap around and pass
+    const uint64_t size = reader.file_.size();
+    for (const auto &section : reader.table()) {
+      if (section.element_size == 0 || section.offset % CacheAlignment != 0 ||
+          section.offset > size ||
+          section.count > (size - section.offset) / section.element_size) {
+        return std::unexpected(false);
+      }
+    }
+    return reader;
+  }
+
+  size_t sections() const { return sections_; }
+
+  template <typename T>
+  std::expected<std::span<const T>, bool> section(size_t index) const {
+    static_assert(std::is_trivially_copyable_v<T>,
+                  "cached records are copied byte for byte");
+    if (index >= sections_ || table()[index].element_size != sizeof(T)) {
+      return std::unexpected(false);
+    }
+    const auto &entry = table()[index];
+    return std::span(
+        reinterpret_cast<const T *>(file_.view().data() + entry.offset),
+        entry.count);
+  }
+
+  // Copy of a section, for days that keep their parsed data in vectors
+  template <typename T>
+  std::expected<std::vector<T>, bool> vector(size_t index) const {
+    auto records = section<T>(index);
+    if (!records) {
+      return std::unexpected(false);
+    }
+    return std::vector<T>(records->begin(), records->end());
+  }
+};
+
+// $PUZZLES_CACHE_DIR, created on first use; nullopt disables caching
+inline std::optional<std::filesystem::path> cacheDirectory() {
+  const char *dir = std::getenv("PUZZLES_CACHE_DIR");
+  if (!dir || !*dir) {
+    return std::nullopt;
+  }
+  std::error_code ec;
+  std::filesystem::create_directories(dir, ec);
+  if (ec) {
+    return std::nullopt;
+  }
+  return std::filesystem::path(dir);
+}
+
+// Parsed input of a day, from the cache when it has a valid entry for this
+// input, otherwise from parse(file_name), which then refreshes the cache.
+// Standard input can only be read once and is never cached.
+//   parse(const path &)                  -> std::expected<Parsed, bool>
+//   store(const Parsed &, CacheWriter &)  adds the sections
+//   load(const CacheReader &)            -> std::expected<Parsed, bool>
+template <typename Parsed, typename Parse, typename Store, typename Load>
+std::expected<Parsed, bool>
+cachedInput(std::string_view day, uint32_t schema,
+            const std::filesystem::path &file_name, Parse &&parse,
+            Store &&store, Load &&load) {
+  auto dir = cacheDirectory();
+  if (!dir || isStandardInput(file_name)) {
+    return parse(file_name);
+  }
+
+  CacheKey key{day, schema, 0, 0};
+  {
+    PUZZLES_TRACE_SCOPE("hash input");
+    auto input = MappedFile::open(file_name);
+    if (!input) {
+      return std::unexpected(false);
+    }
+    key.input_hash = hashBytes(input->view());
+    key.input_size = input->size();
+  }
+  auto cache_file = *dir / std::format("{}-{:016x}.bin", day, key.input_hash);
+
+  if (auto reader = CacheReader::open(cache_file, key)) {
+    PUZZLES_TRACE_SCOPE("cache load");
+    if (auto parsed = load(*reader)) {
+      return parsed;
+    }
+  }
+
+  auto parsed = parse(file_name);
+  if (parsed) {
+    PUZZLES_TRACE_SCOPE("cache store");
+    CacheWriter writer;
+    store(*parsed, writer);
+    if (!writer.write(cache_file, key)) {
+      std::println(stderr, "Cannot write cache file {}", cache_file.string());
+    }
+  }
+  return parsed;
+}
+
+} // namespace puzzles::common
@@ -1,21 +1,72 @@
 #pragma once
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
 #include <charconv>
 #include <concepts>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
 #include <expected>
 #include <filesystem>
 #include <fstream>
 #include <functional>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <optional>
+#include <span>
 #include <sstream>
 #include <string>
+#include <string_view>
+#include <thread>
 #include <tuple>
+#include <utility>
+#include <vector>
+
+#if __has_include(<sys/mman.h>)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define PUZZLES_HAS_MMAP 1
+#endif
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__SSE2__) &&        \
+    __has_include(<immintrin.h>)
+#include <immintrin.h>
+#define PUZZLES_HAS_SSE2 1
+#endif
+
+#include "cpu_dispatch.h"
+#include "trace.h"
 
 namespace puzzles::common {
 template <typename T>
 concept UnsignedInteger = std::unsigned_integral<T> && !std::same_as<T, bool>;
 
+constexpr bool is_digit(char c) {
+  return static_cast<unsigned char>(c - '0') < 10;
+}
+
+constexpr bool is_space(char c) {
+  return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+template <UnsignedInteger T>
+constexpr std::expected<T, std::errc> to_unsigned_swar(std::string_view sval);
+
 template <UnsignedInteger T>
 constexpr std::expected<T, std::errc> to_unsigned(std::string_view sval) {
+  if consteval {
+    // Same results; std::from_chars is not usable in constant expressions
+    // with every standard library yet
+    return to_unsigned_swar<T>(sval);
+  }
   T value{};
   auto result = std::from_chars(sval.data(), sval.data() + sval.size(), value);
   if (result.ec != std::errc{} || result.ptr != sval.data() + sval.size()) {
@@ -25,26 +76,820 @@ constexpr std::expected<T, std::errc> to_unsigned(std::string_view sval) {
   return value;
 }
 
+namespace detail {
+// Little-endian load of 8 characters; folds into a single load when
+// optimised and stays usable in constant expressions.
+constexpr uint64_t load8(const char *chars) {
+  uint64_t chunk = 0;
+  for (int i = 0; i < 8; ++i) {
+    chunk |= static_cast<uint64_t>(static_cast<unsigned char>(chars[i]))
+             << (8 * i);
+  }
+  return chunk;
+}
+
+constexpr bool is_eight_digits(uint64_t chunk) {
+  return ((chunk & 0xF0F0F0F0F0F0F0F0) |
+          (((chunk + 0x0606060606060606) & 0xF0F0F0F0F0F0F0F0) >> 4)) ==
+         0x3333333333333333;
+}
+
+// Value of 8 ASCII digits packed first-digit-lowest, using three multiplies
+constexpr uint64_t parse_eight_digits(uint64_t chunk) {
+  constexpr uint64_t mask = 0x000000FF000000FF;
+  constexpr uint64_t mul1 = 0x000F424000000064; // 100 + (1000000 << 32)
+  constexpr uint64_t mul2 = 0x0000271000000001; // 1 + (10000 << 32)
+  chunk -= 0x3030303030303030;
+  chunk = (chunk * 10) + (chunk >> 8);
+  return (((chunk & mask) * mul1) + (((chunk >> 16) & mask) * mul2)) >> 32;
+}
+} // namespace detail
+
+// SWAR variant of to_unsigned: consumes 8 digits per step and reports the
+// same errors as std::from_chars (invalid_argument for empty input or
+// trailing characters, result_out_of_range when the value exceeds T).
+template <UnsignedInteger T>
+constexpr std::expected<T, std::errc> to_unsigned_swar(std::string_view sval) {
+  static_assert(sizeof(T) <= sizeof(uint64_t), "accumulates in uint64_t");
+  constexpr uint64_t max = std::numeric_limits<T>::max();
+  constexpr uint64_t limit8 = max / 100000000;
+  constexpr uint64_t limit1 = max / 10;
+
+  const char *data = sval.data();
+  const size_t size = sval.size();
+  size_t pos = 0;
+  while (pos < size && data[pos] == '0') {
+    ++pos;
+  }
+
+  uint64_t value = 0;
+  for (; pos + 8 <= size; pos += 8) {
+    uint64_t chunk = detail::load8(data + pos);
+    if (!detail::is_eight_digits(chunk)) {
+      break;
+    }
+    uint64_t digits = detail::parse_eight_digits(chunk);
+    if (value > limit8 || digits > max - value * 100000000) {
+      return std::unexpected(std::errc::result_out_of_range);
+    }
+    value = value * 100000000 + digits;
+  }
+  for (; pos < size && is_digit(data[pos]); ++pos) {
+    uint64_t digit = static_cast<uint64_t>(data[pos] - '0');
+    if (value > limit1 || digit > max - value * 10) {
+      return std::unexpected(std::errc::result_out_of_range);
+    }
+    value = value * 10 + digit;
+  }
+  if (size == 0 || pos != size) {
+    return std::unexpected(std::errc::invalid_argument);
+  }
+  return static_cast<T>(value);
+}
+
+// Batch conversion of already split fields into a contiguous array.
+// Returns the number of values written, or the error of the first field that
+// fails (value_too_large when out cannot hold all fields).
+template <UnsignedInteger T, size_t Extent>
+constexpr std::expected<size_t, std::errc>
+to_unsigned_many(std::span<const std::string_view> fields,
+                 std::span<T, Extent> out) {
+  if (fields.size() > out.size()) {
+    return std::unexpected(std::errc::value_too_large);
+  }
+  for (size_t i = 0; i < fields.size(); ++i) {
+    auto value = to_unsigned_swar<T>(fields[i]);
+    if (!value) {
+      return std::unexpected(value.error());
+    }
+    out[i] = *value;
+  }
+  return fields.size();
+}
+
+// Batch conversion of a delimiter separated buffer ("1,22,333" or one value
+// per line) in a single pass. A single trailing delimiter is accepted, any
+// other empty field is an invalid_argument.
+template <UnsignedInteger T, size_t Extent>
+constexpr std::expected<size_t, std::errc>
+to_unsigned_many(std::string_view buffer, char delimiter,
+                 std::span<T, Extent> out) {
+  size_t count = 0;
+  size_t pos = 0;
+  while (pos < buffer.size()) {
+    size_t end = std::min(buffer.find(delimiter, pos), buffer.size());
+    if (count == out.size()) {
+      return std::unexpected(std::errc::value_too_large);
+    }
+    auto value = to_unsigned_swar<T>(buffer.substr(pos, end - pos));
+    if (!value) {
+      return std::unexpected(value.error());
+    }
+    out[count++] = *value;
+    pos = end + 1;
+  }
+  return count;
+}
+
+// ---------------------------------------------------------------------------
+// Tokenizer
+// Delimiter scanning is done 64 (AVX-512), 32 (AVX2) or 16 (SSE2) bytes at a
+// time as common/cpu_dispatch.h picks, the tail and non-x86 targets fall back
+// to a scalar loop. Nothing here allocates: integer fields are written into
+// caller-provided spans.
+// ---------------------------------------------------------------------------
+
+namespace detail {
+enum class CharClass { Digit, NonDigit, Space, NonSpace, GroupOpen };
+
+template <CharClass Class> constexpr bool matches(char c) {
+  if constexpr (Class == CharClass::Digit) {
+    return is_digit(c);
+  } else if constexpr (Class == CharClass::NonDigit) {
+    return !is_digit(c);
+  } else if constexpr (Class == CharClass::Space) {
+    return is_space(c);
+  } else if constexpr (Class == CharClass::NonSpace) {
+    return !is_space(c);
+  } else {
+    return c == '[' || c == '(' || c == '{';
+  }
+}
+
+#ifdef PUZZLES_HAS_SSE2
+template <CharClass Class> inline unsigned match_mask(__m128i chunk) {
+  __m128i hit;
+  if constexpr (Class == CharClass::Digit || Class == CharClass::NonDigit) {
+    // c - '0' <= 9 as unsigned bytes
+    __m128i shifted = _mm_sub_epi8(chunk, _mm_set1_epi8('0'));
+    hit = _mm_cmpeq_epi8(_mm_min_epu8(shifted, _mm_set1_epi8(9)), shifted);
+  } else if constexpr (Class == CharClass::Space ||
+                       Class == CharClass::NonSpace) {
+    hit = _mm_or_si128(
+        _mm_or_si128(_mm_cmpeq_epi8(chunk, _mm_set1_epi8(' ')),
+                     _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\t'))),
+        _mm_or_si128(_mm_cmpeq_epi8(chunk, _mm_set1_epi8('\r')),
+                     _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\n'))));
+  } else {
+    hit = _mm_or_si128(
+        _mm_or_si128(_mm_cmpeq_epi8(chunk, _mm_set1_epi8('[')),
+                     _mm_cmpeq_epi8(chunk, _mm_set1_epi8('('))),
+        _mm_cmpeq_epi8(chunk, _mm_set1_epi8('{')));
+  }
+  unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(hit));
+  if constexpr (Class == CharClass::NonDigit || Class == CharClass::NonSpace) {
+    mask = ~mask & 0xFFFFu;
+  }
+  return mask;
+}
+#endif
+
+#ifdef PUZZLES_HAS_CPU_DISPATCH
+template <CharClass Class>
+PUZZLES_TARGET_AVX2 inline unsigned match_mask(__m256i chunk) {
+  __m256i hit;
+  if constexpr (Class == CharClass::Digit || Class == CharClass::NonDigit) {
+    __m256i shifted = _mm256_sub_epi8(chunk, _mm256_set1_epi8('0'));
+    hit = _mm256_cmpeq_epi8(_mm256_min_epu8(shifted, _mm256_set1_epi8(9)),
+                            shifted);
+  } else if constexpr (Class == CharClass::Space ||
+                       Class == CharClass::NonSpace) {
+    hit = _mm256_or_si256(
+        _mm256_or_si256(_mm256_cmpeq_epi8(chunk, _mm256_set1_epi8(' ')),
+                        _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('\t'))),
+        _mm256_or_si256(_mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('\r')),
+                        _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('\n'))));
+  } else {
+    hit = _mm256_or_si256(
+        _mm256_or_si256(_mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('[')),
+                        _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('('))),
+        _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('{')));
+  }
+  unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(hit));
+  if constexpr (Class == CharClass::NonDigit || Class == CharClass::NonSpace) {
+    mask = ~mask;
+  }
+  return mask;
+}
+
+template <CharClass Class>
+PUZZLES_TARGET_AVX512 inline uint64_t match_mask(__m512i chunk) {
+  __mmask64 hit;
+  if constexpr (Class == CharClass::Digit || Class == CharClass::NonDigit) {
+    hit = _mm512_cmple_epu8_mask(_mm512_sub_epi8(chunk, _mm512_set1_epi8('0')),
+                                 _mm512_set1_epi8(9));
+  } else if constexpr (Class == CharClass::Space ||
+                       Class == CharClass::NonSpace) {
+    hit = _mm512_cmpeq_epi8_mask(chunk, _mm512_set1_epi8(' ')) |
+          _mm512_cmpeq_epi8_mask(chunk, _mm512_set1_epi8('\t')) |
+          _mm512_cmpeq_epi8_mask(chunk, _mm512_set1_epi8('\r')) |
+          _mm512_cmpeq_epi8_mask(chunk, _mm512_set1_epi8('\n'));
+  } else {
+    hit = _mm512_cmpeq_epi8_mask(chunk, _mm512_set1_epi8('[')) |
+          _mm512_cmpeq_epi8_mask(chunk, _mm512_set1_epi8('(')) |
+          _mm512_cmpeq_epi8_mask(chunk, _mm512_set1_epi8('{'));
+  }
+  uint64_t mask = hit;
+  if constexpr (Class == CharClass::NonDigit || Class == CharClass::NonSpace) {
+    mask = ~mask;
+  }
+  return mask;
+}
+#endif
+
+// Position of the first character of the class at or after pos, or npos.
+// One variant per CPU tier, each finishing its tail with the narrower ones.
+template <CharClass Class>
+inline size_t find_class_scalar(std::string_view text, size_t pos) {
+  for (; pos < text.size(); ++pos) {
+    if (matches<Class>(text[pos])) {
+      return pos;
+    }
+  }
+  return std::string_view::npos;
+}
+
+#ifdef PUZZLES_HAS_SSE2
+template <CharClass Class>
+inline size_t find_class_sse2(std::string_view text, size_t pos) {
+  for (; pos + 16 <= text.size(); pos += 16) {
+    unsigned mask = match_mask<Class>(
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(text.data() + pos)));
+    if (mask) {
+      return pos + std::countr_zero(mask);
+    }
+  }
+  return find_class_scalar<Class>(text, pos);
+}
+#endif
+
+#ifdef PUZZLES_HAS_CPU_DISPATCH
+template <CharClass Class>
+PUZZLES_TARGET_AVX2 inline size_t find_class_avx2(std::string_view text,
+                                                  size_t pos) {
+  for (; pos + 32 <= text.size(); pos += 32) {
+    unsigned mask = match_mask<Class>(_mm256_loadu_si256(
+        reinterpret_cast<const __m256i *>(text.data() + pos)));
+    if (mask) {
+      return pos + std::countr_zero(mask);
+    }
+  }
+  return find_class_sse2<Class>(text, pos);
+}
+
+template <CharClass Class>
+PUZZLES_TARGET_AVX512 inline size_t find_class_avx512(std::string_view text,
+                                                      size_t pos) {
+  for (; pos + 64 <= text.size(); pos += 64) {
+    uint64_t mask = match_mask<Class>(_mm512_loadu_si512(text.data() + pos));
+    if (mask) {
+      return pos + std::countr_zero(mask);
+    }
+  }
+  return find_class_avx2<Class>(text, pos);
+}
+#endif
+
+template <CharClass Class>
+inline size_t find_class(std::string_view text, size_t pos) {
+  static auto *const kernel =
+      KernelVariants<size_t(std::string_view, size_t)> {
+    .scalar = find_class_scalar<Class>,
+#ifdef PUZZLES_HAS_SSE2
+    .sse2 = find_class_sse2<Class>,
+#endif
+#ifdef PUZZLES_HAS_CPU_DISPATCH
+    .avx2 = find_class_avx2<Class>, .avx512 = find_class_avx512<Class>,
+#endif
+  }.select();
+  return kernel(text, pos);
+}
+} // namespace detail
+
+inline size_t find_digit(std::string_view text, size_t pos = 0) {
+  return detail::find_class<detail::CharClass::Digit>(text, pos);
+}
+
+inline size_t find_non_digit(std::string_view text, size_t pos = 0) {
+  return detail::find_class<detail::CharClass::NonDigit>(text, pos);
+}
+
+// Extract every run of decimal digits in text into out, in order. Any other
+// character acts as a delimiter; for signed types a '-' directly in front of
+// a run that does not follow another digit is taken as the sign (so "3-7"
+// still reads as two fields). Returns the number of fields written,
+// value_too_large when out is too small and result_out_of_range when a field
+// does not fit into T.
+template <std::integral T, size_t Extent>
+std::expected<size_t, std::errc> parse_integers(std::string_view text,
+                                                std::span<T, Extent> out) {
+  size_t count = 0;
+  size_t pos = 0;
+  while ((pos = find_digit(text, pos)) != std::string_view::npos) {
+    size_t end = std::min(find_non_digit(text, pos), text.size());
+    size_t begin = pos;
+    if constexpr (std::signed_integral<T>) {
+      if (begin > 0 && text[begin - 1] == '-' &&
+          (begin == 1 || !is_digit(text[begin - 2]))) {
+        --begin;
+      }
+    }
+    if (count == out.size()) {
+      return std::unexpected(std::errc::value_too_large);
+    }
+    if constexpr (UnsignedInteger<T>) {
+      auto value = to_unsigned_swar<T>(text.substr(begin, end - begin));
+      if (!value) {
+        return std::unexpected(value.error());
+      }
+      out[count] = *value;
+    } else {
+      auto result =
+          std::from_chars(text.data() + begin, text.data() + end, out[count]);
+      if (result.ec != std::errc{}) {
+        return std::unexpected(result.ec);
+      }
+    }
+    ++count;
+    pos = end;
+  }
+  return count;
+}
+
+// Next whitespace separated word at or after pos, pos is moved past it.
+// Returns an empty view when the text is exhausted.
+inline std::string_view next_word(std::string_view text, size_t &pos) {
+  size_t begin = detail::find_class<detail::CharClass::NonSpace>(text, pos);
+  if (begin == std::string_view::npos) {
+    pos = text.size();
+    return {};
+  }
+  size_t end = std::min(
+      detail::find_class<detail::CharClass::Space>(text, begin), text.size());
+  pos = end;
+  return text.substr(begin, end - begin);
+}
+
+// Bracketed group as found in lines like "[.##.] (0,2) (1) {3,5}"
+struct Group {
+  char open;             // '[', '(' or '{'
+  std::string_view body; // text between the brackets
+};
+
+constexpr char closing_bracket(char open) {
+  return open == '[' ? ']' : open == '(' ? ')' : '}';
+}
+
+// Next [..], (..) or {..} group at or after pos, pos is moved past it.
+// Groups do not nest; an unterminated group ends the scan.
+inline std::optional<Group> next_group(std::string_view text, size_t &pos) {
+  size_t begin = detail::find_class<detail::CharClass::GroupOpen>(text, pos);
+  if (begin == std::string_view::npos) {
+    pos = text.size();
+    return std::nullopt;
+  }
+  char open = text[begin];
+  size_t end = text.find(closing_bracket(open), begin + 1);
+  if (end == std::string_view::npos) {
+    pos = text.size();
+    return std::nullopt;
+  }
+  pos = end + 1;
+  return Group{open, text.substr(begin + 1, end - begin - 1)};
+}
+
+template <typename T> struct is_std_function : std::false_type {};
+template <typename Signature>
+struct is_std_function<std::function<Signature>> : std::true_type {};
+
+// Per-line callback: gets the line and the accumulator, returns false to
+// abort reading.
+template <typename Visitor, typename ReturnType>
+concept LineVisitor =
+    std::invocable<Visitor &, std::string_view, ReturnType &> &&
+    std::convertible_to<
+        std::invoke_result_t<Visitor &, std::string_view, ReturnType &>,
+        bool> &&
+    !is_std_function<std::remove_cvref_t<Visitor>>::value;
+
+// Per-chunk callback: gets a span of consecutive lines and the accumulator.
+template <typename Visitor, typename ReturnType>
+concept BatchVisitor =
+    std::invocable<Visitor &, std::span<const std::string_view>,
+                   ReturnType &> &&
+    std::convertible_to<std::invoke_result_t<Visitor &,
+                                             std::span<const std::string_view>,
+                                             ReturnType &>,
+                        bool>;
+
+// Lines handed to a BatchVisitor per call.
+constexpr size_t DefaultBatchLines = 256;
+
+// Statically dispatched reader: the visitor type is a template parameter, so
+// the callback is inlined into the read loop. Lambdas passed to
+// readFileByLine<ReturnType>(...) bind here rather than to the std::function
+// overload below.
+// The optional accumulate argument is the initial value, e.g. a pmr
+// container bound to an InputArena.
+template <typename ReturnType, LineVisitor<ReturnType> Visitor>
+std::expected<ReturnType, bool>
+readFileByLine(const std::filesystem::path &file_name, Visitor &&readbyline,
+               ReturnType accumulate = ReturnType{}) {
+  PUZZLES_TRACE_SCOPE("read");
+  std::ifstream inputFile(file_name);
+  if (!inputFile.is_open()) {
+    return std::unexpected(false);
+  }
+  std::string line;
+  while (std::getline(inputFile, line))
+    if (!readbyline(std::string_view(line), accumulate)) {
+      return std::unexpected(false);
+    }
+  return accumulate;
+}
+
+// Type-erased variant, kept for callers that already hold a std::function.
 template <typename ReturnType>
 std::expected<ReturnType, bool> readFileByLine(
     const std::filesystem::path &file_name,
     const std::function<bool(std::string_view, ReturnType &accumulate)>
         &readbyline) {
-  std::ifstream inputFile(file_name);
-  if (inputFile.is_open()) {
-    if (readbyline) {
-      std::string line;
-      ReturnType accumulate{};
-      while (std::getline(inputFile, line))
-        if (!readbyline(line, accumulate)) {
-          return std::unexpected(false);
-        }
-      return accumulate;
-    } else {
+  if (!readbyline) {
+    return std::unexpected(false);
+  }
+  return readFileByLine<ReturnType>(
+      file_name, [&readbyline](std::string_view line, ReturnType &accumulate) {
+        return readbyline(line, accumulate);
+      });
+}
+
+// Bump allocator for everything a day derives from its input. One buffer is
+// allocated up front, sized from the input file; deallocate is a no-op and
+// all memory goes away with the arena. If the estimate is too small the
+// resource keeps going with geometrically growing upstream blocks.
+class InputArena {
+  static constexpr size_t MinBytes = 4096;
+
+  std::unique_ptr<std::byte[]> buffer_;
+  std::pmr::monotonic_buffer_resource resource_;
+
+public:
+  explicit InputArena(size_t bytes)
+      : buffer_(std::make_unique_for_overwrite<std::byte[]>(
+            std::max(bytes, MinBytes))),
+        resource_(buffer_.get(), std::max(bytes, MinBytes)) {}
+
+  // bytes_per_input_byte is the day's estimate of how much it stores per
+  // byte of input
+  InputArena(const std::filesystem::path &file_name,
+             size_t bytes_per_input_byte)
+      : InputArena(estimate(file_name, bytes_per_input_byte)) {}
+
+  InputArena(const InputArena &) = delete;
+  InputArena &operator=(const InputArena &) = delete;
+
+  std::pmr::memory_resource *resource() { return &resource_; }
+
+  static size_t estimate(const std::filesystem::path &file_name,
+                         size_t bytes_per_input_byte) {
+    std::error_code ec;
+    auto size = std::filesystem::file_size(file_name, ec);
+    return ec ? MinBytes : size * bytes_per_input_byte + MinBytes;
+  }
+};
+
+// Whole-input line storage for days that keep every line; pass
+// ArenaLines(arena.resource()) as the reader's initial accumulator.
+using ArenaLines = std::pmr::vector<std::pmr::string>;
+
+// The input "-" stands for standard input
+inline bool isStandardInput(const std::filesystem::path &file_name) {
+  return file_name == "-";
+}
+
+// Read-only view over the whole content of a file.
+// Regular files are memory mapped, anything else (pipes, FIFOs, character
+// devices, standard input, platforms without mmap) is drained into an owned
+// buffer.
+class MappedFile {
+  std::string buffer_{};
+  const char *data_ = nullptr;
+  size_t size_ = 0;
+  bool mapped_ = false;
+
+  MappedFile() = default;
+
+  void release() noexcept {
+#ifdef PUZZLES_HAS_MMAP
+    if (mapped_) {
+      ::munmap(const_cast<char *>(data_), size_);
+    }
+#endif
+    data_ = nullptr;
+    size_ = 0;
+    mapped_ = false;
+  }
+
+  static MappedFile readStandardInput() {
+    MappedFile file;
+    char chunk[65536];
+    size_t got = 0;
+    while ((got = std::fread(chunk, 1, sizeof(chunk), stdin)) > 0) {
+      file.buffer_.append(chunk, got);
+    }
+    file.data_ = file.buffer_.data();
+    file.size_ = file.buffer_.size();
+    return file;
+  }
+
+  static std::expected<MappedFile, bool>
+  readStream(const std::filesystem::path &file_name) {
+    std::ifstream inputFile(file_name, std::ios::binary);
+    if (!inputFile.is_open()) {
+      return std::unexpected(false);
+    }
+    MappedFile file;
+    file.buffer_.assign(std::istreambuf_iterator<char>(inputFile),
+                        std::istreambuf_iterator<char>());
+    file.data_ = file.buffer_.data();
+    file.size_ = file.buffer_.size();
+    return file;
+  }
+
+public:
+  ~MappedFile() { release(); }
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+
+  MappedFile(MappedFile &&right) noexcept
+      : buffer_(std::move(right.buffer_)), data_(right.data_),
+        size_(right.size_), mapped_(right.mapped_) {
+    if (!mapped_) {
+      data_ = buffer_.data();
+    }
+    right.data_ = nullptr;
+    right.size_ = 0;
+    right.mapped_ = false;
+  }
+
+  MappedFile &operator=(MappedFile &&right) noexcept {
+    if (this != &right) {
+      release();
+      buffer_ = std::move(right.buffer_);
+      data_ = right.mapped_ ? right.data_ : buffer_.data();
+      size_ = right.size_;
+      mapped_ = right.mapped_;
+      right.data_ = nullptr;
+      right.size_ = 0;
+      right.mapped_ = false;
+    }
+    return *this;
+  }
+
+  static std::expected<MappedFile, bool>
+  open(const std::filesystem::path &file_name) {
+    if (isStandardInput(file_name)) {
+      return readStandardInput();
+    }
+#ifdef PUZZLES_HAS_MMAP
+    int fd = ::open(file_name.c_str(), O_RDONLY);
+    if (fd < 0) {
       return std::unexpected(false);
     }
+    struct stat st {};
+    if (::fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+      ::close(fd);
+      return readStream(file_name); // Pipe or device, no mapping possible
+    }
+    MappedFile file;
+    if (st.st_size > 0) {
+      void *addr = ::mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ,
+                          MAP_PRIVATE, fd, 0);
+      if (addr == MAP_FAILED) {
+        ::close(fd);
+        return readStream(file_name);
+      }
+      ::madvise(addr, static_cast<size_t>(st.st_size), MADV_SEQUENTIAL);
+      file.data_ = static_cast<const char *>(addr);
+      file.size_ = static_cast<size_t>(st.st_size);
+      file.mapped_ = true;
+    }
+    ::close(fd);
+    return file;
+#else
+    return readStream(file_name);
+#endif
+  }
+
+  std::string_view view() const { return {data_, size_}; }
+  size_t size() const { return size_; }
+  bool isMapped() const { return mapped_; }
+};
+
+// Split a buffer into lines with std::getline semantics: no empty line is
+// produced after a final newline, a missing final newline is tolerated and a
+// trailing '\r' (CRLF input) is stripped from every line.
+// Stops and returns false as soon as the callback returns false.
+// Usable in constant expressions, e.g. over an embedded input.
+template <typename Callback>
+constexpr bool forEachLine(std::string_view data, Callback &&callback) {
+  size_t pos = 0;
+  while (pos < data.size()) {
+    size_t end = data.size();
+    if consteval {
+      end = std::min(data.find('\n', pos), data.size());
+    } else {
+      const void *found =
+          std::memchr(data.data() + pos, '\n', data.size() - pos);
+      if (found) {
+        end = static_cast<size_t>(static_cast<const char *>(found) -
+                                  data.data());
+      }
+    }
+    std::string_view line = data.substr(pos, end - pos);
+    if (!line.empty() && line.back() == '\r') {
+      line.remove_suffix(1);
+    }
+    if (!callback(line)) {
+      return false;
+    }
+    pos = end + 1;
+  }
+  return true;
+}
+
+// Zero-copy counterpart of readFileByLine: same accumulate contract, but the
+// lines are views straight into the mapped file instead of std::string
+// copies. Switching a day over is a matter of changing the function name.
+template <typename ReturnType, LineVisitor<ReturnType> Visitor>
+std::expected<ReturnType, bool>
+readFileByLineMapped(const std::filesystem::path &file_name,
+                     Visitor &&readbyline,
+                     ReturnType accumulate = ReturnType{}) {
+  PUZZLES_TRACE_SCOPE("read");
+  auto file = MappedFile::open(file_name);
+  if (!file) {
+    return std::unexpected(false);
+  }
+  if (!forEachLine(file->view(), [&](std::string_view line) {
+        return readbyline(line, accumulate);
+      })) {
+    return std::unexpected(false);
+  }
+  return accumulate;
+}
+
+template <typename ReturnType>
+std::expected<ReturnType, bool> readFileByLineMapped(
+    const std::filesystem::path &file_name,
+    const std::function<bool(std::string_view, ReturnType &accumulate)>
+        &readbyline) {
+  if (!readbyline) {
+    return std::unexpected(false);
+  }
+  return readFileByLineMapped<ReturnType>(
+      file_name, [&readbyline](std::string_view line, ReturnType &accumulate) {
+        return readbyline(line, accumulate);
+      });
+}
+
+// Batch reader over the mapped file: the visitor receives up to batch_lines
+// consecutive lines at once, which lets the parsing loop live inside the
+// visitor instead of behind a call per line.
+template <typename ReturnType, BatchVisitor<ReturnType> Visitor>
+std::expected<ReturnType, bool>
+readFileByBatch(const std::filesystem::path &file_name, Visitor &&readbatch,
+                size_t batch_lines = DefaultBatchLines) {
+  PUZZLES_TRACE_SCOPE("read");
+  auto file = MappedFile::open(file_name);
+  if (!file || batch_lines == 0) {
+    return std::unexpected(false);
+  }
+  std::vector<std::string_view> batch;
+  batch.reserve(batch_lines);
+  ReturnType accumulate{};
+  bool ok = forEachLine(file->view(), [&](std::string_view line) {
+    batch.push_back(line);
+    if (batch.size() < batch_lines) {
+      return true;
+    }
+    bool keep_going = readbatch(std::span<const std::string_view>(batch),
+                                accumulate);
+    batch.clear();
+    return keep_going;
+  });
+  if (ok && !batch.empty()) {
+    ok = readbatch(std::span<const std::string_view>(batch), accumulate);
+  }
+  if (!ok) {
+    return std::unexpected(false);
+  }
+  return accumulate;
+}
+
+// Cut data into at most `parts` pieces of roughly equal size, each ending
+// right after a newline (the last one at the end of data).
+inline std::vector<std::string_view>
+splitAtLineBoundaries(std::string_view data, size_t parts) {
+  std::vector<std::string_view> chunks;
+  if (parts == 0) {
+    parts = 1;
+  }
+  size_t begin = 0;
+  for (size_t i = 1; i <= parts && begin < data.size(); ++i) {
+    size_t end = data.size();
+    if (i < parts) {
+      end = std::max(begin, data.size() / parts * i);
+      size_t newline = data.find('\n', end);
+      end = (newline == std::string_view::npos) ? data.size() : newline + 1;
+    }
+    chunks.push_back(data.substr(begin, end - begin));
+    begin = end;
+  }
+  return chunks;
+}
+
+// How readFileParallel combines chunk results
+enum class MergeOrder {
+  Ordered,    // left fold in file order, merge only has to be associative
+  AsCompleted // folded as chunks finish, merge must also be commutative
+};
+
+// Map/reduce reader: the mapped file is split at line boundaries into one
+// chunk per thread, every chunk is read into its own ReturnType{} and the
+// chunk results are combined with merge(into, std::move(chunk)).
+// The visitor runs concurrently on different accumulators, so it must not
+// touch shared state. With MergeOrder::Ordered a chunk result may be a
+// summary that only makes sense relative to the chunks before it (e.g. a
+// dial offset), because merge sees chunks strictly in file order.
+template <typename ReturnType, LineVisitor<ReturnType> Visitor, typename Merge>
+  requires std::invocable<Merge &, ReturnType &, ReturnType &&>
+std::expected<ReturnType, bool>
+readFileParallel(const std::filesystem::path &file_name, Visitor &&readbyline,
+                 Merge &&merge, MergeOrder order = MergeOrder::Ordered,
+                 size_t threads = 0) {
+  PUZZLES_TRACE_SCOPE("read");
+  auto file = MappedFile::open(file_name);
+  if (!file) {
+    return std::unexpected(false);
+  }
+  if (threads == 0) {
+    threads = std::max(1u, std::thread::hardware_concurrency());
+  }
+  const auto chunks = splitAtLineBoundaries(file->view(), threads);
+
+  std::vector<std::optional<ReturnType>> results(chunks.size());
+  std::optional<ReturnType> merged{};
+  std::mutex merge_mutex;
+  std::atomic<bool> failed{false};
+
+  auto readChunk = [&](size_t idx) {
+    PUZZLES_TRACE_SCOPE("read chunk");
+    ReturnType accumulate{};
+    bool ok = forEachLine(chunks[idx], [&](std::string_view line) {
+      return !failed.load(std::memory_order_relaxed) &&
+             readbyline(line, accumulate);
+    });
+    if (!ok) {
+      failed = true;
+      return;
+    }
+    if (order == MergeOrder::AsCompleted) {
+      std::lock_guard lock(merge_mutex);
+      if (merged) {
+        merge(*merged, std::move(accumulate));
+      } else {
+        merged = std::move(accumulate);
+      }
+    } else {
+      results[idx] = std::move(accumulate);
+    }
+  };
+
+  {
+    std::vector<std::jthread> workers;
+    workers.reserve(chunks.size());
+    for (size_t idx = 1; idx < chunks.size(); ++idx) {
+      workers.emplace_back(readChunk, idx);
+    }
+    if (!chunks.empty()) {
+      readChunk(0);
+    }
+  }
+
+  if (failed) {
+    return std::unexpected(false);
+  }
+  if (order == MergeOrder::Ordered) {
+    for (auto &result : results) {
+      if (merged) {
+        merge(*merged, std::move(*result));
+      } else {
+        merged = std::move(result);
+      }
+    }
   }
-  return std::unexpected(false);
+  return merged ? std::move(*merged) : ReturnType{};
 }
 
 constexpr auto InputFileError = "Error reading input file.";
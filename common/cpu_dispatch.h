@@ -0,0 +1,114 @@
+#pragma once
+
+#include <cstdlib>
+#include <optional>
+#include <print>
+#include <string_view>
+
+// Runtime CPU feature dispatch. Kernels with SIMD variants compile each
+// variant for its instruction set with PUZZLES_TARGET_AVX2 /
+// PUZZLES_TARGET_AVX512 in the same build, and pick one through
+// KernelVariants::select() on first use, so one binary runs on any x86-64.
+// $PUZZLES_CPU_TIER=scalar|sse2|avx2|avx512 forces a lower tier than the CPU
+// offers, e.g. to benchmark the variants against each other.
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__)) &&       \
+    __has_include(<immintrin.h>)
+#include <immintrin.h>
+#define PUZZLES_HAS_CPU_DISPATCH 1
+#define PUZZLES_TARGET_AVX2 [[gnu::target("avx2")]]
+#define PUZZLES_TARGET_AVX512 [[gnu::target("avx512f,avx512bw")]]
+#endif
+
+namespace puzzles::common {
+
+// Instruction set tiers, each including the ones before
+enum class CpuTier { Scalar, SSE2, AVX2, AVX512 };
+
+constexpr std::string_view cpuTierName(CpuTier tier) {
+  switch (tier) {
+  case CpuTier::Scalar:
+    return "scalar";
+  case CpuTier::SSE2:
+    return "sse2";
+  case CpuTier::AVX2:
+    return "avx2";
+  case CpuTier::AVX512:
+    return "avx512";
+  }
+  return "unknown";
+}
+
+constexpr std::optional<CpuTier> parseCpuTier(std::string_view name) {
+  for (auto tier :
+       {CpuTier::Scalar, CpuTier::SSE2, CpuTier::AVX2, CpuTier::AVX512}) {
+    if (name == cpuTierName(tier)) {
+      return tier;
+    }
+  }
+  return std::nullopt;
+}
+
+// Highest tier the CPU and the operating system support
+inline CpuTier detectCpuTier() {
+#ifdef PUZZLES_HAS_CPU_DISPATCH
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw")) {
+    return CpuTier::AVX512;
+  }
+  if (__builtin_cpu_supports("avx2")) {
+    return CpuTier::AVX2;
+  }
+  return CpuTier::SSE2;
+#elif defined(__SSE2__)
+  return CpuTier::SSE2;
+#else
+  return CpuTier::Scalar;
+#endif
+}
+
+// Tier the kernels run at: the detected one, lowered by $PUZZLES_CPU_TIER.
+// Determined once per process.
+inline CpuTier cpuTier() {
+  static const CpuTier tier = [] {
+    CpuTier detected = detectCpuTier();
+    const char *forced = std::getenv("PUZZLES_CPU_TIER");
+    if (!forced || !*forced) {
+      return detected;
+    }
+    auto requested = parseCpuTier(forced);
+    if (!requested) {
+      std::println(stderr, "Unknown PUZZLES_CPU_TIER {}, using {}", forced,
+                   cpuTierName(detected));
+      return detected;
+    }
+    if (*requested > detected) {
+      std::println(stderr, "CPU does not support {}, using {}",
+                   cpuTierName(*requested), cpuTierName(detected));
+      return detected;
+    }
+    return *requested;
+  }();
+  return tier;
+}
+
+// One kernel compiled for several tiers. Missing variants fall back to the
+// next lower tier that has one; the scalar variant is required.
+template <typename Fn> struct KernelVariants {
+  Fn *scalar;
+  Fn *sse2 = nullptr;
+  Fn *avx2 = nullptr;
+  Fn *avx512 = nullptr;
+
+  Fn *select(CpuTier tier = cpuTier()) const {
+    Fn *const by_tier[] = {scalar, sse2, avx2, avx512};
+    for (int i = static_cast<int>(tier); i > 0; --i) {
+      if (by_tier[i]) {
+        return by_tier[i];
+      }
+    }
+    return scalar;
+  }
+};
+
+} // namespace puzzles::common
@@ -0,0 +1,31 @@
+#pragma once
+
+// Embedded input build mode. Configure with -DPUZZLES_EMBED_INPUT=ON and the
+// default input of every puzzle target (its INPUT_FILE) is compiled into the
+// program with #embed. Days that can parse and solve in constant
+// expressions then compute their answers while compiling and only print
+// them at run time; any other input path given on the command line is still
+// read and solved at run time.
+
+#if defined(PUZZLES_EMBED_INPUT) && defined(INPUT_FILE)
+
+#include <string_view>
+
+#define PUZZLES_HAS_EMBEDDED_INPUT
+
+namespace puzzles::common {
+// Internal linkage: the combined runner links every day's copy side by side
+namespace {
+constexpr char embedded_input_data[] = {
+#embed INPUT_FILE suffix(, )
+    '\0'};
+
+// The default input as text, without the terminating null
+constexpr std::string_view embeddedInput() {
+  return {embedded_input_data, sizeof(embedded_input_data) - 1};
+}
+} // namespace
+
+} // namespace puzzles::common
+
+#endif
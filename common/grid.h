@@ -0,0 +1,347 @@
+#pragma once
+
+#include "common.h"
+#include "cpu_dispatch.h"
+#include <algorithm>
+#include <bit>
+#include <concepts>
+#include <cstddef>
+#include <expected>
+#include <filesystem>
+#include <memory>
+#include <memory_resource>
+#include <ranges>
+#include <span>
+#include <string_view>
+#include <vector>
+
+namespace puzzles::common {
+
+// Rectangle of cells [row, row + rows) x [col, col + cols)
+struct GridTile {
+  int row;
+  int col;
+  int rows;
+  int cols;
+};
+
+// Dense 2D grid in one row-major allocation, surrounded by `border` rings of
+// sentinel cells. Cells are addressed as grid(row, col) with
+// -border <= row < rows + border (and likewise for columns), so a stencil
+// reaching up to `border` cells away needs no bounds checks.
+template <typename T, typename Allocator = std::allocator<T>> class Grid {
+  static_assert(!std::same_as<T, bool>, "use char cells instead of bool");
+
+public:
+  using value_type = T;
+  using allocator_type = Allocator;
+
+  Grid(int rows, int cols, int border = 1, const T &fill = T{},
+       const Allocator &alloc = Allocator())
+      : rows_(rows), cols_(cols), border_(border), stride_(cols + 2 * border),
+        origin_(static_cast<ptrdiff_t>(border) * stride_ + border),
+        cells_(static_cast<size_t>(rows + 2 * border) * stride_, fill,
+               alloc) {}
+
+  // Copy into storage from another allocator, e.g. a different arena
+  Grid(const Grid &other, const Allocator &alloc)
+      : rows_(other.rows_), cols_(other.cols_), border_(other.border_),
+        stride_(other.stride_), origin_(other.origin_),
+        cells_(other.cells_, alloc) {}
+
+  Grid(const Grid &) = default;
+  Grid(Grid &&) noexcept = default;
+  Grid &operator=(const Grid &) = default;
+  Grid &operator=(Grid &&) noexcept = default;
+
+  // Lines of text up to the first blank one; rows shorter than the longest
+  // are padded with `fill`, which is also the border value
+  static Grid fromText(std::string_view text, int border, T fill,
+                       const Allocator &alloc = Allocator())
+    requires std::same_as<T, char>
+  {
+    int rows = 0;
+    size_t cols = 0;
+    forEachLine(text, [&](std::string_view line) {
+      if (line.empty()) {
+        return false;
+      }
+      ++rows;
+      cols = std::max(cols, line.size());
+      return true;
+    });
+    Grid grid(rows, static_cast<int>(cols), border, fill, alloc);
+    int row = 0;
+    forEachLine(text, [&](std::string_view line) {
+      if (line.empty()) {
+        return false;
+      }
+      std::ranges::copy(line, grid.row(row++).begin());
+      return true;
+    });
+    return grid;
+  }
+
+  int rows() const { return rows_; }
+  int cols() const { return cols_; }
+  int border() const { return border_; }
+  // Distance in cells between vertically adjacent cells
+  ptrdiff_t stride() const { return stride_; }
+
+  T &operator()(int row, int col) {
+    return cells_[origin_ + row * stride_ + col];
+  }
+  const T &operator()(int row, int col) const {
+    return cells_[origin_ + row * stride_ + col];
+  }
+
+  bool contains(int row, int col) const {
+    return row >= 0 && row < rows_ && col >= 0 && col < cols_;
+  }
+
+  // Interior cells of one row; the border cells sit at [-border, 0) and
+  // [cols, cols + border) around the span's data pointer
+  std::span<T> row(int row) { return {&(*this)(row, 0), size_t(cols_)}; }
+  std::span<const T> row(int row) const {
+    return {&(*this)(row, 0), size_t(cols_)};
+  }
+
+  // Interior cells of one column as a strided random access view
+  auto col(int col) { return strided(&(*this)(0, col), rows_, stride_); }
+  auto col(int col) const {
+    return strided(&(*this)(0, col), rows_, stride_);
+  }
+
+  // Whole storage including the border, row-major
+  std::span<T> cells() { return cells_; }
+  std::span<const T> cells() const { return cells_; }
+
+  void fill(const T &value) { std::ranges::fill(cells_, value); }
+
+  // Covers the interior with tiles of at most tile_rows x tile_cols, row of
+  // tiles by row of tiles, so a stencil sweep touches a working set of a few
+  // tile rows instead of whole grid rows
+  auto tiles(int tile_rows, int tile_cols) const {
+    const int across = (cols_ + tile_cols - 1) / tile_cols;
+    const int down = (rows_ + tile_rows - 1) / tile_rows;
+    return std::views::iota(0, across * down) |
+           std::views::transform([=, this](int index) {
+             const int row = index / across * tile_rows;
+             const int col = index % across * tile_cols;
+             return GridTile{row, col, std::min(tile_rows, rows_ - row),
+                             std::min(tile_cols, cols_ - col)};
+           });
+  }
+
+private:
+  template <typename Cell>
+  static auto strided(Cell *first, int count, ptrdiff_t stride) {
+    return std::views::iota(0, count) |
+           std::views::transform([first, stride](int index) -> Cell & {
+             return first[index * stride];
+           });
+  }
+
+  int rows_;
+  int cols_;
+  int border_;
+  ptrdiff_t stride_;
+  ptrdiff_t origin_;
+  std::vector<T, Allocator> cells_;
+};
+
+// Transposed view of a grid: view(row, col) is grid(col, row), rows become
+// columns and the other way round. No cells are copied.
+template <typename G> class TransposedGrid {
+  G *grid_;
+
+public:
+  explicit TransposedGrid(G &grid) : grid_(&grid) {}
+
+  int rows() const { return grid_->cols(); }
+  int cols() const { return grid_->rows(); }
+
+  decltype(auto) operator()(int row, int col) const {
+    return (*grid_)(col, row);
+  }
+  auto row(int row) const { return grid_->col(row); }
+  auto col(int col) const { return grid_->row(col); }
+};
+
+template <typename T, typename Allocator>
+TransposedGrid<Grid<T, Allocator>> transposed(Grid<T, Allocator> &grid) {
+  return TransposedGrid<Grid<T, Allocator>>(grid);
+}
+
+template <typename T, typename Allocator>
+TransposedGrid<const Grid<T, Allocator>>
+transposed(const Grid<T, Allocator> &grid) {
+  return TransposedGrid<const Grid<T, Allocator>>(grid);
+}
+
+// Grid whose cells live in an InputArena
+template <typename T>
+using ArenaGrid = Grid<T, std::pmr::polymorphic_allocator<T>>;
+
+namespace detail {
+using SparseCellsFn = size_t(const char *above, const char *here,
+                             const char *below, int begin, int end, char cell,
+                             int limit, int *out);
+
+inline size_t sparse_cells_scalar(const char *above, const char *here,
+                                  const char *below, int begin, int end,
+                                  char cell, int limit, int *out) {
+  size_t found = 0;
+  for (int j = begin; j < end; ++j) {
+    if (here[j] != cell) {
+      continue;
+    }
+    int adjacent = (above[j - 1] == cell) + (above[j] == cell) +
+                   (above[j + 1] == cell) + (here[j - 1] == cell) +
+                   (here[j + 1] == cell) + (below[j - 1] == cell) +
+                   (below[j] == cell) + (below[j + 1] == cell);
+    if (adjacent < limit) {
+      out[found++] = j;
+    }
+  }
+  return found;
+}
+
+// The vector variants count the neighbours of 16, 32 or 64 cells at once:
+// a byte compare yields -1 per match, so subtracting the eight compares
+// leaves the count in each byte
+#ifdef PUZZLES_HAS_SSE2
+inline __m128i equal_cells(const char *cells, __m128i target) {
+  return _mm_cmpeq_epi8(
+      _mm_loadu_si128(reinterpret_cast<const __m128i *>(cells)), target);
+}
+
+inline size_t sparse_cells_sse2(const char *above, const char *here,
+                                const char *below, int begin, int end,
+                                char cell, int limit, int *out) {
+  const __m128i target = _mm_set1_epi8(cell);
+  const __m128i bound = _mm_set1_epi8(static_cast<char>(limit));
+  size_t found = 0;
+  int j = begin;
+  for (; j + 16 <= end; j += 16) {
+    __m128i count = _mm_setzero_si128();
+    for (const char *row : {above, here, below}) {
+      count = _mm_sub_epi8(count, equal_cells(row + j - 1, target));
+      count = _mm_sub_epi8(count, equal_cells(row + j + 1, target));
+    }
+    count = _mm_sub_epi8(count, equal_cells(above + j, target));
+    count = _mm_sub_epi8(count, equal_cells(below + j, target));
+    unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(_mm_and_si128(
+        equal_cells(here + j, target), _mm_cmpgt_epi8(bound, count))));
+    for (; mask != 0; mask &= mask - 1) {
+      out[found++] = j + std::countr_zero(mask);
+    }
+  }
+  return found + sparse_cells_scalar(above, here, below, j, end, cell, limit,
+                                     out + found);
+}
+#endif
+
+#ifdef PUZZLES_HAS_CPU_DISPATCH
+PUZZLES_TARGET_AVX2 inline __m256i equal_cells(const char *cells,
+                                               __m256i target) {
+  return _mm256_cmpeq_epi8(
+      _mm256_loadu_si256(reinterpret_cast<const __m256i *>(cells)), target);
+}
+
+PUZZLES_TARGET_AVX2 inline size_t
+sparse_cells_avx2(const char *above, const char *here, const char *below,
+                  int begin, int end, char cell, int limit, int *out) {
+  const __m256i target = _mm256_set1_epi8(cell);
+  const __m256i bound = _mm256_set1_epi8(static_cast<char>(limit));
+  size_t found = 0;
+  int j = begin;
+  for (; j + 32 <= end; j += 32) {
+    __m256i count = _mm256_setzero_si256();
+    for (const char *row : {above, here, below}) {
+      count = _mm256_sub_epi8(count, equal_cells(row + j - 1, target));
+      count = _mm256_sub_epi8(count, equal_cells(row + j + 1, target));
+    }
+    count = _mm256_sub_epi8(count, equal_cells(above + j, target));
+    count = _mm256_sub_epi8(count, equal_cells(below + j, target));
+    auto mask = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_and_si256(
+        equal_cells(here + j, target), _mm256_cmpgt_epi8(bound, count))));
+    for (; mask != 0; mask &= mask - 1) {
+      out[found++] = j + std::countr_zero(mask);
+    }
+  }
+  return found + sparse_cells_sse2(above, here, below, j, end, cell, limit,
+                                   out + found);
+}
+
+PUZZLES_TARGET_AVX512 inline __mmask64 equal_cells(const char *cells,
+                                                   __m512i target) {
+  return _mm512_cmpeq_epi8_mask(_mm512_loadu_si512(cells), target);
+}
+
+PUZZLES_TARGET_AVX512 inline size_t
+sparse_cells_avx512(const char *above, const char *here, const char *below,
+                    int begin, int end, char cell, int limit, int *out) {
+  const __m512i target = _mm512_set1_epi8(cell);
+  const __m512i bound = _mm512_set1_epi8(static_cast<char>(limit));
+  const __m512i one = _mm512_set1_epi8(1);
+  size_t found = 0;
+  int j = begin;
+  for (; j + 64 <= end; j += 64) {
+    __m512i count = _mm512_setzero_si512();
+    for (const char *row : {above, here, below}) {
+      count = _mm512_mask_add_epi8(count, equal_cells(row + j - 1, target),
+                                   count, one);
+      count = _mm512_mask_add_epi8(count, equal_cells(row + j + 1, target),
+                                   count, one);
+    }
+    count = _mm512_mask_add_epi8(count, equal_cells(above + j, target), count,
+                                 one);
+    count = _mm512_mask_add_epi8(count, equal_cells(below + j, target), count,
+                                 one);
+    uint64_t mask = equal_cells(here + j, target) &
+                    _mm512_cmplt_epi8_mask(count, bound);
+    for (; mask != 0; mask &= mask - 1) {
+      out[found++] = j + std::countr_zero(mask);
+    }
+  }
+  return found + sparse_cells_avx2(above, here, below, j, end, cell, limit,
+                                   out + found);
+}
+#endif
+} // namespace detail
+
+// Columns j in [begin, end) of the row `here` whose cell is `cell` and has
+// fewer than `limit` (at most 127) of its 8 neighbours equal to `cell`,
+// written to out in ascending order; returns how many. `above` and `below`
+// are the adjacent rows and columns begin - 1 and end of all three have to be
+// readable, as the border of a Grid makes them.
+inline size_t sparse_cells(const char *above, const char *here,
+                           const char *below, int begin, int end, char cell,
+                           int limit, int *out) {
+  static auto *const kernel = KernelVariants<detail::SparseCellsFn> {
+    .scalar = detail::sparse_cells_scalar,
+#ifdef PUZZLES_HAS_SSE2
+    .sse2 = detail::sparse_cells_sse2,
+#endif
+#ifdef PUZZLES_HAS_CPU_DISPATCH
+    .avx2 = detail::sparse_cells_avx2, .avx512 = detail::sparse_cells_avx512,
+#endif
+  }.select();
+  return kernel(above, here, below, begin, end, cell, limit, out);
+}
+
+// Reads a character grid; see Grid::fromText for the layout rules
+template <typename Allocator = std::allocator<char>>
+std::expected<Grid<char, Allocator>, bool>
+readGrid(const std::filesystem::path &file_name, int border, char fill,
+         const Allocator &alloc = Allocator()) {
+  PUZZLES_TRACE_SCOPE("read");
+  auto file = MappedFile::open(file_name);
+  if (!file) {
+    return std::unexpected(false);
+  }
+  return Grid<char, Allocator>::fromText(file->view(), border, fill, alloc);
+}
+
+} // namespace puzzles::common
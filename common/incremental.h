@@ -0,0 +1,120 @@
+#pragma once
+
+// Incremental runs over inputs that only ever grow by appends. A day keeps
+// its accumulator after the last complete line in a checkpoint, together
+// with the byte offset of that line's end and a hash of the bytes before
+// it. The next run over the same path checks the hash, restores the
+// accumulator and parses only the appended tail; if the prefix changed, or
+// the file shrank, it starts over from byte 0.
+//
+// Incremental mode is off unless $PUZZLES_STATE_DIR names a directory.
+// Checkpoints are cache files (see cache.h) named after the day and the
+// absolute input path; the header's input hash and size hold the prefix
+// hash and offset.
+
+#include "cache.h"
+#include "common.h"
+#include "trace.h"
+#include <cstdint>
+#include <cstdlib>
+#include <expected>
+#include <filesystem>
+#include <format>
+#include <optional>
+#include <print>
+#include <string_view>
+
+namespace puzzles::common {
+
+// $PUZZLES_STATE_DIR, created on first use; nullopt disables incremental runs
+inline std::optional<std::filesystem::path> stateDirectory() {
+  const char *dir = std::getenv("PUZZLES_STATE_DIR");
+  if (!dir || !*dir) {
+    return std::nullopt;
+  }
+  std::error_code ec;
+  std::filesystem::create_directories(dir, ec);
+  if (ec) {
+    return std::nullopt;
+  }
+  return std::filesystem::path(dir);
+}
+
+// Whether solving `file_name` goes through incrementalInput. Standard input
+// has no earlier contents to resume from.
+inline bool incrementalMode(const std::filesystem::path &file_name) {
+  return !isStandardInput(file_name) && stateDirectory().has_value();
+}
+
+// Accumulator of a day after the whole input, resumed from the checkpoint of
+// an earlier run when its prefix is unchanged. Only complete lines advance
+// the checkpoint; a last line without its newline is applied to a copy, as
+// it may still be in the middle of being appended.
+//   advance(std::string_view lines, State &) -> bool, false on bad input
+//   store(const State &, CacheWriter &)       adds the sections
+//   load(const CacheReader &)                 -> std::expected<State, bool>
+template <typename State, typename Advance, typename Store, typename Load>
+std::expected<State, bool>
+incrementalInput(std::string_view day, uint32_t schema,
+                 const std::filesystem::path &file_name, Advance &&advance,
+                 Store &&store, Load &&load) {
+  auto input = MappedFile::open(file_name);
+  auto dir = stateDirectory();
+  if (!input || !dir) {
+    return std::unexpected(false);
+  }
+  const std::string_view text = input->view();
+
+  std::error_code ec;
+  auto absolute = std::filesystem::absolute(file_name, ec);
+  auto state_file =
+      *dir / std::format("{}-{:016x}.state", day,
+                         hashBytes((ec ? file_name : absolute).string()));
+
+  State state{};
+  size_t offset = 0;
+  if (auto header = readCacheHeader(state_file);
+      header && header->schema == schema && header->input_size > 0 &&
+      header->input_size <= text.size()) {
+    PUZZLES_TRACE_SCOPE("resume checkpoint");
+    const CacheKey key{day, schema, header->input_hash, header->input_size};
+    if (hashBytes(text.substr(0, header->input_size)) == header->input_hash) {
+      if (auto reader = CacheReader::open(state_file, key)) {
+        if (auto loaded = load(*reader)) {
+          state = std::move(*loaded);
+          offset = header->input_size;
+        }
+      }
+    }
+  }
+
+  // Everything up to the last newline moves the checkpoint; npos wraps to 0
+  const size_t complete = text.rfind('\n') + 1;
+  if (complete > offset) {
+    {
+      PUZZLES_TRACE_SCOPE("advance");
+      if (!advance(text.substr(offset, complete - offset), state)) {
+        return std::unexpected(false);
+      }
+    }
+    PUZZLES_TRACE_SCOPE("store checkpoint");
+    CacheWriter writer;
+    store(state, writer);
+    const CacheKey key{day, schema, hashBytes(text.substr(0, complete)),
+                       complete};
+    if (!writer.write(state_file, key)) {
+      std::println(stderr, "Cannot write state file {}", state_file.string());
+    }
+  }
+
+  if (complete < text.size()) {
+    State answer = state;
+    if (!advance(text.substr(complete), answer)) {
+      return std::unexpected(false);
+    }
+    return answer;
+  }
+  return state;
+}
+
+} // namespace puzzles::common
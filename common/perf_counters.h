@@ -0,0 +1,271 @@
+#pragma once
+
+// Hardware performance counters per phase. Configure with
+// -DPUZZLES_PERF_COUNTERS=ON and every PUZZLES_TRACE_SCOPE also samples
+// cycles, instructions, cache misses, branch misses and dTLB misses of the
+// thread it runs on through perf_event_open. Totals per phase name are
+// written at exit to $PUZZLES_PERF_FILE, or stderr when it is unset, one
+// tab separated line per phase:
+//   phase <name> <calls> <wall ms> <cycles> <instructions> ...
+// A counter the kernel refuses (no PMU in a container or VM, a strict
+// perf_event_paranoid) is written as "-"; the program itself runs as before.
+
+#ifdef PUZZLES_PERF_COUNTERS
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <optional>
+#include <print>
+#include <string_view>
+#include <vector>
+
+#if __has_include(<linux/perf_event.h>)
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#define PUZZLES_HAS_PERF_EVENTS
+#endif
+
+namespace puzzles::common {
+
+struct PerfEvent {
+  std::string_view name;
+  uint32_t type;
+  uint64_t config;
+};
+
+#ifdef PUZZLES_HAS_PERF_EVENTS
+inline constexpr std::array<PerfEvent, 5> PerfEvents{{
+    {"cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+    {"instructions", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+    {"cache-misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+    {"branch-misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+    {"dtlb-misses", PERF_TYPE_HW_CACHE,
+     PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+         (PERF_COUNT_HW_CACHE_RESULT_MISS << 16)},
+}};
+#else
+inline constexpr std::array<PerfEvent, 5> PerfEvents{{
+    {"cycles", 0, 0},
+    {"instructions", 0, 0},
+    {"cache-misses", 0, 0},
+    {"branch-misses", 0, 0},
+    {"dtlb-misses", 0, 0},
+}};
+#endif
+
+// One reading of every counter; nullopt where the counter is unavailable
+using PerfSample = std::array<std::optional<uint64_t>, PerfEvents.size()>;
+
+// Counters of the calling thread, opened on its first sample. Each event is
+// opened on its own so one the PMU lacks does not take the others with it.
+class ThreadPerfCounters {
+public:
+  static ThreadPerfCounters &current() {
+    thread_local ThreadPerfCounters counters{};
+    return counters;
+  }
+
+  ThreadPerfCounters(const ThreadPerfCounters &) = delete;
+  ThreadPerfCounters &operator=(const ThreadPerfCounters &) = delete;
+  ~ThreadPerfCounters() {
+#ifdef PUZZLES_HAS_PERF_EVENTS
+    for (int fd : fds_) {
+      if (fd >= 0) {
+        ::close(fd);
+      }
+    }
+#endif
+  }
+
+  // Values are scaled up when the kernel multiplexed the counter
+  PerfSample read() const {
+    PerfSample sample{};
+#ifdef PUZZLES_HAS_PERF_EVENTS
+    for (size_t i = 0; i < fds_.size(); ++i) {
+      struct {
+        uint64_t value;
+        uint64_t enabled;
+        uint64_t running;
+      } reading{};
+      if (fds_[i] < 0 ||
+          ::read(fds_[i], &reading, sizeof(reading)) != sizeof(reading) ||
+          reading.running == 0) {
+        continue;
+      }
+      sample[i] = reading.running == reading.enabled
+                      ? reading.value
+                      : static_cast<uint64_t>(
+                            static_cast<double>(reading.value) *
+                            static_cast<double>(reading.enabled) /
+                            static_cast<double>(reading.running));
+    }
+#endif
+    return sample;
+  }
+
+  // errno of the first event that failed to open, 0 when all opened
+  int error() const { return error_; }
+
+private:
+  ThreadPerfCounters() {
+    fds_.fill(-1);
+#ifdef PUZZLES_HAS_PERF_EVENTS
+    for (size_t i = 0; i < PerfEvents.size(); ++i) {
+      perf_event_attr attr{};
+      attr.size = sizeof(attr);
+      attr.type = PerfEvents[i].type;
+      attr.config = PerfEvents[i].config;
+      attr.read_format =
+          PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+      attr.exclude_kernel = 1;
+      attr.exclude_hv = 1;
+      long fd = ::syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+      if (fd < 0 && error_ == 0) {
+        error_ = errno;
+      }
+      fds_[i] = static_cast<int>(fd);
+    }
+#else
+    error_ = ENOSYS;
+#endif
+  }
+
+  std::array<int, PerfEvents.size()> fds_;
+  int error_ = 0;
+};
+
+struct PerfPhaseTotals {
+  std::string_view name;
+  uint64_t calls = 0;
+  double wall_ms = 0.0;
+  PerfSample counters{};
+};
+
+// Totals per phase name over all threads, written out when the process
+// exits
+class PerfCounters {
+public:
+  static PerfCounters &instance() {
+    static PerfCounters counters{};
+    return counters;
+  }
+
+  PerfCounters(const PerfCounters &) = delete;
+  PerfCounters &operator=(const PerfCounters &) = delete;
+  ~PerfCounters() {
+    const char *path = std::getenv("PUZZLES_PERF_FILE");
+    write(path && *path ? path : nullptr);
+  }
+
+  void add(std::string_view name, double wall_ms, const PerfSample &begin,
+           const PerfSample &end) {
+    std::lock_guard lock(mutex_);
+    auto it = std::ranges::find(phases_, name, &PerfPhaseTotals::name);
+    if (it == phases_.end()) {
+      it = phases_.insert(phases_.end(), PerfPhaseTotals{name});
+      // A counter stays available only while every sample of it is
+      for (auto &counter : it->counters) {
+        counter = 0;
+      }
+    }
+    ++it->calls;
+    it->wall_ms += wall_ms;
+    for (size_t i = 0; i < PerfEvents.size(); ++i) {
+      if (it->counters[i] && begin[i] && end[i]) {
+        *it->counters[i] += *end[i] - *begin[i];
+      } else {
+        it->counters[i].reset();
+      }
+    }
+  }
+
+  void noteError(int error) {
+    std::lock_guard lock(mutex_);
+    if (error_ == 0) {
+      error_ = error;
+    }
+  }
+
+  // Phases in order of first completion; stderr when path is null
+  bool write(const char *path) {
+    std::lock_guard lock(mutex_);
+    std::FILE *out = path ? std::fopen(path, "w") : stderr;
+    if (!out) {
+      std::println(stderr, "Cannot write perf counter file {}", path);
+      return false;
+    }
+    std::print(out, "# phase\tname\tcalls\twall_ms");
+    for (const auto &event : PerfEvents) {
+      std::print(out, "\t{}", event.name);
+    }
+    std::println(out, "");
+    if (error_ != 0) {
+      std::println(out, "# counters unavailable: {}", std::strerror(error_));
+    }
+    for (const auto &phase : phases_) {
+      std::print(out, "phase\t{}\t{}\t{:.3f}", phase.name, phase.calls,
+                 phase.wall_ms);
+      for (const auto &counter : phase.counters) {
+        if (counter) {
+          std::print(out, "\t{}", *counter);
+        } else {
+          std::print(out, "\t-");
+        }
+      }
+      std::println(out, "");
+    }
+    return path ? std::fclose(out) == 0 : true;
+  }
+
+private:
+  PerfCounters() = default;
+
+  std::mutex mutex_;
+  std::vector<PerfPhaseTotals> phases_;
+  int error_ = 0;
+};
+
+// Counts [construction, end()) of the current thread as one call of a phase
+class PerfScope {
+public:
+  explicit PerfScope(std::string_view name)
+      : name_(name), start_(std::chrono::steady_clock::now()) {
+    auto &counters = ThreadPerfCounters::current();
+    if (counters.error() != 0) {
+      PerfCounters::instance().noteError(counters.error());
+    }
+    begin_ = counters.read();
+  }
+  PerfScope(const PerfScope &) = delete;
+  PerfScope &operator=(const PerfScope &) = delete;
+  ~PerfScope() { end(); }
+
+  void end() {
+    if (!ended_) {
+      ended_ = true;
+      PerfSample end = ThreadPerfCounters::current().read();
+      double wall_ms = std::chrono::duration<double, std::milli>(
+                           std::chrono::steady_clock::now() - start_)
+                           .count();
+      PerfCounters::instance().add(name_, wall_ms, begin_, end);
+    }
+  }
+
+private:
+  std::string_view name_;
+  std::chrono::steady_clock::time_point start_;
+  PerfSample begin_;
+  bool ended_ = false;
+};
+
+} // namespace puzzles::common
+
+#endif
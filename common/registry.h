@@ -0,0 +1,80 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Input used when no path is given on the command line; CMake defines
+// INPUT_FILE per puzzle target.
+#ifdef INPUT_FILE
+#define PUZZLES_DEFAULT_INPUT INPUT_FILE
+#else
+#define PUZZLES_DEFAULT_INPUT ""
+#endif
+
+namespace puzzles::common {
+
+// Everything a solver gets from the outside world. Answers go to `out`, so
+// several days can run inside one process without mixing their output.
+struct SolverContext {
+  std::filesystem::path input;        // argv[1] or the registered default
+  std::vector<std::string_view> args; // remaining command line arguments
+  std::FILE *out = stdout;
+};
+
+using SolverFn = int (*)(const SolverContext &ctx);
+
+struct Solver {
+  std::string_view name;
+  std::filesystem::path default_input;
+  SolverFn solve;
+};
+
+inline std::vector<Solver> &solvers() {
+  static std::vector<Solver> registry{};
+  return registry;
+}
+
+inline const Solver *findSolver(std::string_view name) {
+  auto &registry = solvers();
+  auto it = std::ranges::find(registry, name, &Solver::name);
+  return it == registry.end() ? nullptr : &*it;
+}
+
+struct SolverRegistration {
+  SolverRegistration(std::string_view name, std::string_view default_input,
+                     SolverFn solve) {
+    solvers().push_back(Solver{name, default_input, solve});
+    std::ranges::sort(solvers(), {}, &Solver::name);
+  }
+};
+
+// Build the context the same way the per-day executables read argv:
+// the first argument is the input file, the rest is passed through.
+inline SolverContext makeContext(const Solver &solver,
+                                 std::span<char *const> argv,
+                                 std::FILE *out = stdout) {
+  SolverContext ctx{};
+  ctx.input = argv.empty() ? solver.default_input
+                           : std::filesystem::path(argv.front());
+  for (auto *arg : argv.subspan(argv.empty() ? 0 : 1)) {
+    ctx.args.emplace_back(arg);
+  }
+  ctx.out = out;
+  return ctx;
+}
+
+} // namespace puzzles::common
+
+// Registers a day's solver with the process wide registry. Every puzzle source
+// is compiled once into an object library that is linked both into its own
+// executable (with common/solver_main.cpp) and into the combined runner.
+#define PUZZLES_REGISTER_SOLVER(name, fn)                                      \
+  namespace {                                                                  \
+  const ::puzzles::common::SolverRegistration solver_registration{             \
+      name, PUZZLES_DEFAULT_INPUT, fn};                                        \
+  }
@@ -0,0 +1,31 @@
+/*
+ * Entry point shared by the per-day executables: runs the one solver that is
+ * registered in the program, with argv[1] as the input file.
+ * With $PUZZLES_POOL_STATS set the thread pool utilisation goes to stderr.
+ */
+
+#include "registry.h"
+#include "thread_pool.h"
+#include "trace.h"
+#include <cstdlib>
+#include <print>
+
+int main(int argc, char *argv[]) {
+  namespace pc = puzzles::common;
+
+  const auto &registry = pc::solvers();
+  if (registry.size() != 1) {
+    std::println(stderr, "Expected exactly one registered solver, found {}",
+                 registry.size());
+    return 1;
+  }
+  const auto &solver = registry.front();
+  PUZZLES_TRACE_SCOPE(solver.name);
+  const size_t arg_count = argc > 1 ? static_cast<size_t>(argc - 1) : 0;
+  int status = solver.solve(
+      pc::makeContext(solver, std::span<char *const>(argv + 1, arg_count)));
+  if (std::getenv("PUZZLES_POOL_STATS")) {
+    pc::printPoolStats(stderr);
+  }
+  return status;
+}
@@ -0,0 +1,415 @@
+#pragma once
+
+// Streaming input: a background thread reads the input ahead of the
+// consumer into a ring of large buffers, the consumer parses whole lines
+// into records and a bounded lock-free queue hands batches of records to
+// solver threads. Disk reads, parsing and solving overlap, which suits days
+// whose lines can be solved on their own.
+//
+// The input "-" is standard input, so data can be piped in.
+
+#include "common.h"
+#include "thread_pool.h"
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <concepts>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <expected>
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace puzzles::common {
+
+// Bounded multi-producer multi-consumer queue (D. Vyukov's design): every
+// slot carries a sequence number telling producers and consumers whose turn
+// it is, so try_push/try_pop take no lock. The blocking push/pop spin
+// briefly and then sleep on an atomic until the queue changes.
+template <typename T> class BoundedQueue {
+public:
+  // Capacity is rounded up to a power of two
+  explicit BoundedQueue(size_t capacity)
+      : mask_(std::bit_ceil(std::max<size_t>(capacity, 2)) - 1),
+        slots_(std::make_unique<Slot[]>(mask_ + 1)) {
+    for (size_t i = 0; i <= mask_; ++i) {
+      slots_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+  }
+  BoundedQueue(const BoundedQueue &) = delete;
+  BoundedQueue &operator=(const BoundedQueue &) = delete;
+
+  // Moves from value only when it was queued
+  bool try_push(T &value) {
+    size_t pos = tail_.load(std::memory_order_relaxed);
+    while (true) {
+      Slot &slot = slots_[pos & mask_];
+      size_t sequence = slot.sequence.load(std::memory_order_acquire);
+      auto lag = static_cast<std::ptrdiff_t>(sequence - pos);
+      if (lag == 0) {
+        if (tail_.compare_exchange_weak(pos, pos + 1,
+                                        std::memory_order_relaxed)) {
+          slot.value = std::move(value);
+          slot.sequence.store(pos + 1, std::memory_order_release);
+          changed();
+          return true;
+        }
+      } else if (lag < 0) {
+        return false; // full
+      } else {
+        pos = tail_.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  std::optional<T> try_pop() {
+    size_t pos = head_.load(std::memory_order_relaxed);
+    while (true) {
+      Slot &slot = slots_[pos & mask_];
+      size_t sequence = slot.sequence.load(std::memory_order_acquire);
+      auto lag = static_cast<std::ptrdiff_t>(sequence - (pos + 1));
+      if (lag == 0) {
+        if (head_.compare_exchange_weak(pos, pos + 1,
+                                        std::memory_order_relaxed)) {
+          T value = std::move(slot.value);
+          slot.sequence.store(pos + mask_ + 1, std::memory_order_release);
+          changed();
+          return value;
+        }
+      } else if (lag < 0) {
+        return std::nullopt; // empty
+      } else {
+        pos = head_.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  // Waits for room; false once the queue is closed
+  bool push(T value) {
+    bool pushed = false;
+    waitUntil([&] { return closed() || (pushed = try_push(value)); });
+    return pushed;
+  }
+
+  // Waits for a value; nullopt once the queue is closed and drained
+  std::optional<T> pop() {
+    std::optional<T> value;
+    waitUntil([&] {
+      value = try_pop();
+      return value.has_value() || closed();
+    });
+    if (!value) {
+      value = try_pop(); // queued just before close()
+    }
+    return value;
+  }
+
+  // Wakes every waiter; pushes fail from now on, pops drain what is left
+  void close() {
+    closed_.store(true, std::memory_order_release);
+    changed();
+  }
+
+  bool closed() const { return closed_.load(std::memory_order_acquire); }
+
+private:
+  struct Slot {
+    std::atomic<size_t> sequence;
+    T value{};
+  };
+
+  void changed() {
+    changes_.fetch_add(1);
+    if (waiters_.load() > 0) {
+      changes_.notify_all();
+    }
+  }
+
+  // The change counter is read before the condition is checked, so a
+  // change made after the check makes wait() return at once
+  template <typename Ready> void waitUntil(Ready &&ready) {
+    for (int spin = 0; spin < 64; ++spin) {
+      if (ready()) {
+        return;
+      }
+    }
+    while (true) {
+      uint32_t seen = changes_.load();
+      if (ready()) {
+        return;
+      }
+      waiters_.fetch_add(1);
+      changes_.wait(seen);
+      waiters_.fetch_sub(1);
+    }
+  }
+
+  const size_t mask_;
+  std::unique_ptr<Slot[]> slots_;
+  alignas(64) std::atomic<size_t> head_{0};
+  alignas(64) std::atomic<size_t> tail_{0};
+  alignas(64) std::atomic<uint32_t> changes_{0};
+  std::atomic<uint32_t> waiters_{0};
+  std::atomic<bool> closed_{false};
+};
+
+// Input file, or standard input for "-"; only a file of our own is closed
+using InputStream = std::unique_ptr<std::FILE, void (*)(std::FILE *)>;
+
+inline std::expected<InputStream, bool>
+openInputStream(const std::filesystem::path &file_name) {
+  if (isStandardInput(file_name)) {
+    return InputStream(stdin, [](std::FILE *) {});
+  }
+  std::FILE *file = std::fopen(file_name.c_str(), "rb");
+  if (!file) {
+    return std::unexpected(false);
+  }
+  return InputStream(file, [](std::FILE *file) { std::fclose(file); });
+}
+
+// Reads a stream on a background thread into `blocks` buffers of about
+// block_size bytes. Every block ends after a newline (or at the end of the
+// input), so it holds whole lines only; a line longer than a block grows
+// the buffer. Blocks come back to the reader through release().
+class ReadAhead {
+public:
+  struct Block {
+    size_t index;
+    std::string_view text;
+  };
+
+  ReadAhead(std::FILE *input, size_t block_size, size_t blocks)
+      : input_(input), block_size_(std::max<size_t>(block_size, 4096)),
+        buffers_(std::max<size_t>(blocks, 2)), free_(buffers_.size()),
+        full_(buffers_.size()) {
+    for (size_t i = 0; i < buffers_.size(); ++i) {
+      buffers_[i].data = std::make_unique<char[]>(block_size_);
+      buffers_[i].capacity = block_size_;
+      size_t index = i;
+      free_.try_push(index);
+    }
+    thread_ = std::jthread([this] { readLoop(); });
+  }
+  ReadAhead(const ReadAhead &) = delete;
+  ReadAhead &operator=(const ReadAhead &) = delete;
+
+  ~ReadAhead() {
+    free_.close();
+    full_.close();
+  }
+
+  // Next block in input order; nullopt at the end of the input
+  std::optional<Block> next() {
+    auto index = full_.pop();
+    if (!index) {
+      return std::nullopt;
+    }
+    const auto &buffer = buffers_[*index];
+    return Block{*index, {buffer.data.get(), buffer.size}};
+  }
+
+  void release(size_t index) { free_.push(index); }
+
+  // The input could not be read to the end
+  bool failed() const { return failed_.load(std::memory_order_acquire); }
+
+private:
+  struct Buffer {
+    std::unique_ptr<char[]> data;
+    size_t capacity = 0;
+    size_t size = 0;
+  };
+
+  void readLoop() {
+    std::string carry; // partial last line of the previous block
+    bool done = false;
+    while (!done) {
+      auto index = free_.pop();
+      if (!index) {
+        return; // the consumer stopped early
+      }
+      PUZZLES_TRACE_SCOPE("read ahead");
+      Buffer &buffer = buffers_[*index];
+      buffer.size = 0;
+      if (carry.size() >= buffer.capacity) {
+        grow(buffer, carry.size() * 2);
+      }
+      std::memcpy(buffer.data.get(), carry.data(), carry.size());
+      buffer.size = carry.size();
+      carry.clear();
+
+      while (true) {
+        if (buffer.size == buffer.capacity) {
+          grow(buffer, buffer.capacity * 2);
+        }
+        size_t got = std::fread(buffer.data.get() + buffer.size, 1,
+                                buffer.capacity - buffer.size, input_);
+        buffer.size += got;
+        if (got == 0) {
+          done = true;
+          if (std::ferror(input_)) {
+            failed_.store(true, std::memory_order_release);
+          }
+          break;
+        }
+        std::string_view text(buffer.data.get(), buffer.size);
+        size_t newline = text.rfind('\n');
+        if (newline != std::string_view::npos) {
+          carry.assign(text.substr(newline + 1));
+          buffer.size = newline + 1;
+          break;
+        }
+      }
+      if (buffer.size == 0 || !full_.push(*index)) {
+        break;
+      }
+    }
+    full_.close();
+  }
+
+  static void grow(Buffer &buffer, size_t capacity) {
+    auto data = std::make_unique<char[]>(capacity);
+    std::memcpy(data.get(), buffer.data.get(), buffer.size);
+    buffer.data = std::move(data);
+    buffer.capacity = capacity;
+  }
+
+  std::FILE *input_;
+  const size_t block_size_;
+  std::vector<Buffer> buffers_;
+  BoundedQueue<size_t> free_;
+  BoundedQueue<size_t> full_;
+  std::atomic<bool> failed_{false};
+  std::jthread thread_; // last, joined before the rest goes
+};
+
+struct PipelineOptions {
+  size_t workers = 0;          // solver threads, 0 uses the pool size
+  size_t batch_records = 64;   // records per hand-off to a solver
+  size_t block_size = 1 << 20; // read-ahead buffer size
+  size_t blocks = 4;           // read-ahead buffers
+};
+
+// Streaming reader: the input is read ahead on a background thread, this
+// thread runs parse(line, records) to append the records of every line and
+// solver threads run solve(span of records, result) on batches of them,
+// each into its own Result{}. The per-thread results are combined with
+// merge(into, std::move(part)) in thread order.
+// Records may hold views of the line: a block of input stays alive until
+// every batch cut from it is solved. With one worker the batches are solved
+// in input order, so a day whose lines depend on the ones before can still
+// overlap its I/O and parsing with the solving.
+// Either callback returns false to abort, which makes the read fail.
+template <typename Record, typename Result, typename Parse, typename Solve,
+          typename Merge>
+  requires std::invocable<Parse &, std::string_view, std::vector<Record> &> &&
+           std::invocable<Solve &, std::span<const Record>, Result &> &&
+           std::invocable<Merge &, Result &, Result &&>
+std::expected<Result, bool>
+readFilePipelined(const std::filesystem::path &file_name, Parse &&parse,
+                  Solve &&solve, Merge &&merge,
+                  PipelineOptions options = {}) {
+  PUZZLES_TRACE_SCOPE("pipeline");
+  auto input = openInputStream(file_name);
+  if (!input) {
+    return std::unexpected(false);
+  }
+  const size_t workers =
+      options.workers ? options.workers : ThreadPool::global().size();
+  const size_t batch_records = std::max<size_t>(options.batch_records, 1);
+
+  struct Batch {
+    std::vector<Record> records;
+    size_t block = 0;
+  };
+  ReadAhead reader(input->get(), options.block_size, options.blocks);
+  BoundedQueue<Batch> batches(2 * workers);
+  BoundedQueue<std::vector<Record>> spare(2 * workers + 2);
+  // Parser plus unsolved batches per block; the last one out hands the
+  // block back to the reader
+  std::vector<std::atomic<size_t>> block_users(std::max<size_t>(
+      options.blocks, 2));
+  std::atomic<bool> failed{false};
+  auto releaseBlock = [&](size_t block) {
+    if (block_users[block].fetch_sub(1, std::memory_order_acq_rel) == 1) {
+      reader.release(block);
+    }
+  };
+
+  std::vector<Result> results(workers);
+  {
+    std::vector<std::jthread> solvers;
+    for (size_t worker = 0; worker < workers; ++worker) {
+      solvers.emplace_back([&, worker] {
+        PUZZLES_TRACE_SCOPE("solve batches");
+        while (auto batch = batches.pop()) {
+          if (!failed.load(std::memory_order_relaxed) &&
+              !solve(std::span<const Record>(batch->records),
+                     results[worker])) {
+            failed.store(true, std::memory_order_relaxed);
+          }
+          releaseBlock(batch->block);
+          batch->records.clear();
+          spare.try_push(batch->records);
+        }
+      });
+    }
+
+    PUZZLES_TRACE_BEGIN(parse_scope, "parse");
+    auto records = spare.try_pop().value_or(std::vector<Record>{});
+    while (!failed.load(std::memory_order_relaxed)) {
+      auto block = reader.next();
+      if (!block) {
+        break;
+      }
+      block_users[block->index].store(1, std::memory_order_relaxed);
+      auto flush = [&] {
+        if (records.empty()) {
+          return true;
+        }
+        block_users[block->index].fetch_add(1, std::memory_order_relaxed);
+        if (!batches.push(Batch{std::move(records), block->index})) {
+          return false;
+        }
+        records = spare.try_pop().value_or(std::vector<Record>{});
+        return true;
+      };
+      bool ok = forEachLine(block->text, [&](std::string_view line) {
+        return parse(line, records) &&
+               (records.size() < batch_records || flush()) &&
+               !failed.load(std::memory_order_relaxed);
+      });
+      // Batches never span blocks, so a block is free once its last batch
+      // is solved
+      if (!ok || !flush()) {
+        failed.store(true, std::memory_order_relaxed);
+      }
+      releaseBlock(block->index);
+    }
+    PUZZLES_TRACE_END(parse_scope);
+    if (reader.failed()) {
+      failed.store(true, std::memory_order_relaxed);
+    }
+    batches.close();
+  }
+
+  if (failed.load(std::memory_order_relaxed)) {
+    return std::unexpected(false);
+  }
+  Result total = std::move(results.front());
+  for (auto &result : std::span(results).subspan(1)) {
+    merge(total, std::move(result));
+  }
+  return total;
+}
+
+} // namespace puzzles::common
@@ -0,0 +1,428 @@
+#pragma once
+
+// Work-stealing thread pool with fork/join helpers.
+//
+// Every worker owns a deque: it pushes and pops its own tasks at the back
+// and idle workers steal from the front of the others. Threads outside the
+// pool share one extra queue. A thread waiting for a TaskGroup runs queued
+// tasks and only sleeps while there are none, so groups can be nested
+// freely. Every task is traced as its own scope, on the track of the thread
+// that runs it.
+//
+// ThreadPool::global() is sized by $PUZZLES_THREADS, defaulting to the
+// number of hardware threads; the thread that waits counts as one of them.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <concepts>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <print>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "common.h"
+
+namespace puzzles::common {
+
+struct ThreadPoolStats {
+  size_t threads = 0;      // workers plus the waiting thread
+  uint64_t tasks = 0;      // tasks run
+  uint64_t steals = 0;     // tasks run by a thread that did not queue them
+  double busy_ms = 0.0;    // summed over all threads
+  double elapsed_ms = 0.0; // since the pool was created
+
+  // Share of the available thread time spent running tasks
+  double utilisation() const {
+    return elapsed_ms > 0.0 && threads > 0
+               ? busy_ms / (elapsed_ms * static_cast<double>(threads))
+               : 0.0;
+  }
+};
+
+class ThreadPool {
+public:
+  using Task = std::function<void()>;
+
+  // threads == 0 uses the hardware concurrency
+  explicit ThreadPool(size_t threads = 0) {
+    if (threads == 0) {
+      threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    // Queue 0 belongs to threads outside the pool
+    for (size_t i = 0; i < threads; ++i) {
+      queues_.push_back(std::make_unique<Queue>());
+    }
+    for (size_t i = 1; i < threads; ++i) {
+      workers_.emplace_back([this, i] { workerLoop(i); });
+    }
+  }
+
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool &operator=(const ThreadPool &) = delete;
+
+  ~ThreadPool() {
+    {
+      std::lock_guard lock(sleep_mutex_);
+      stop_ = true;
+    }
+    wake_.notify_all();
+    workers_.clear(); // joins
+  }
+
+  static ThreadPool &global() {
+    static ThreadPool pool(threadsFromEnvironment());
+    return pool;
+  }
+
+  size_t size() const { return queues_.size(); }
+
+  void submit(Task task) {
+    auto &queue = *queues_[ownQueue()];
+    {
+      std::lock_guard lock(queue.mutex);
+      queue.tasks.push_back(std::move(task));
+    }
+    pending_.fetch_add(1, std::memory_order_release);
+    {
+      // Pairs with the predicate check of a worker going to sleep
+      std::lock_guard lock(sleep_mutex_);
+    }
+    wake_.notify_one();
+  }
+
+  // Runs one queued task on the calling thread, if there is one
+  bool runOne() {
+    const size_t own = ownQueue();
+    if (auto task = pop(own)) {
+      execute(*task, own, false);
+      return true;
+    }
+    for (size_t i = 1; i < queues_.size(); ++i) {
+      size_t victim = (own + i) % queues_.size();
+      if (auto task = steal(victim)) {
+        execute(*task, own, true);
+        return true;
+      }
+    }
+    return false;
+  }
+
+  // Blocks until done() holds or a task is queued. Whoever makes done() true
+  // calls notifyAll() afterwards.
+  template <typename Done> void waitForWork(Done done) {
+    std::unique_lock lock(sleep_mutex_);
+    wake_.wait(lock, [&] {
+      return done() || pending_.load(std::memory_order_acquire) > 0;
+    });
+  }
+
+  void notifyAll() {
+    {
+      // Pairs with the predicate check of a thread going to sleep
+      std::lock_guard lock(sleep_mutex_);
+    }
+    wake_.notify_all();
+  }
+
+  ThreadPoolStats stats() const {
+    ThreadPoolStats stats{};
+    stats.threads = queues_.size();
+    for (const auto &queue : queues_) {
+      stats.tasks += queue->executed.load(std::memory_order_relaxed);
+      stats.steals += queue->stolen.load(std::memory_order_relaxed);
+      stats.busy_ms += queue->busy_ns.load(std::memory_order_relaxed) / 1e6;
+    }
+    stats.elapsed_ms = std::chrono::duration<double, std::milli>(
+                           std::chrono::steady_clock::now() - created_)
+                           .count();
+    return stats;
+  }
+
+private:
+  struct Queue {
+    std::mutex mutex;
+    std::deque<Task> tasks;
+    // Counters of the thread(s) owning the queue
+    std::atomic<uint64_t> executed{0};
+    std::atomic<uint64_t> stolen{0};
+    std::atomic<uint64_t> busy_ns{0};
+  };
+
+  static size_t threadsFromEnvironment() {
+    const char *value = std::getenv("PUZZLES_THREADS");
+    if (!value || !*value) {
+      return 0;
+    }
+    auto threads = to_unsigned<size_t>(value);
+    return threads ? *threads : 0;
+  }
+
+  // Worker index on this pool's threads, 0 elsewhere
+  size_t ownQueue() const {
+    return current_pool_ == this ? current_queue_ : 0;
+  }
+
+  std::optional<Task> pop(size_t index) {
+    auto &queue = *queues_[index];
+    std::lock_guard lock(queue.mutex);
+    if (queue.tasks.empty()) {
+      return std::nullopt;
+    }
+    Task task = std::move(queue.tasks.back());
+    queue.tasks.pop_back();
+    pending_.fetch_sub(1, std::memory_order_relaxed);
+    return task;
+  }
+
+  std::optional<Task> steal(size_t index) {
+    auto &queue = *queues_[index];
+    std::lock_guard lock(queue.mutex);
+    if (queue.tasks.empty()) {
+      return std::nullopt;
+    }
+    Task task = std::move(queue.tasks.front());
+    queue.tasks.pop_front();
+    pending_.fetch_sub(1, std::memory_order_relaxed);
+    return task;
+  }
+
+  void execute(Task &task, size_t own, bool stolen) {
+    // A task waiting for a nested group runs other tasks inside its own
+    // time, so only the outermost one counts as busy time
+    const bool outermost = task_depth_++ == 0;
+    auto start = std::chrono::steady_clock::now();
+    {
+      PUZZLES_TRACE_SCOPE("pool task");
+      task();
+    }
+    --task_depth_;
+    auto &queue = *queues_[own];
+    if (outermost) {
+      queue.busy_ns.fetch_add(
+          std::chrono::duration_cast<std::chrono::nanoseconds>(
+              std::chrono::steady_clock::now() - start)
+              .count(),
+          std::memory_order_relaxed);
+    }
+    queue.executed.fetch_add(1, std::memory_order_relaxed);
+    if (stolen) {
+      queue.stolen.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+
+  void workerLoop(size_t index) {
+    current_pool_ = this;
+    current_queue_ = index;
+    while (true) {
+      if (runOne()) {
+        continue;
+      }
+      std::unique_lock lock(sleep_mutex_);
+      wake_.wait(lock, [this] {
+        return stop_ || pending_.load(std::memory_order_acquire) > 0;
+      });
+      if (stop_) {
+        return;
+      }
+    }
+  }
+
+  static thread_local const ThreadPool *current_pool_;
+  static thread_local size_t current_queue_;
+  static thread_local int task_depth_;
+
+  std::vector<std::unique_ptr<Queue>> queues_;
+  std::atomic<size_t> pending_{0};
+  std::mutex sleep_mutex_;
+  std::condition_variable wake_;
+  bool stop_ = false;
+  std::chrono::steady_clock::time_point created_ =
+      std::chrono::steady_clock::now();
+  std::vector<std::jthread> workers_; // last, joined before the rest goes
+};
+
+inline thread_local const ThreadPool *ThreadPool::current_pool_ = nullptr;
+inline thread_local size_t ThreadPool::current_queue_ = 0;
+inline thread_local int ThreadPool::task_depth_ = 0;
+
+// Tasks that are waited for together. cancel() drops the tasks that have
+// not started yet; running ones can poll cancelled() to stop early. The
+// first exception thrown by a task is rethrown from wait().
+class TaskGroup {
+public:
+  explicit TaskGroup(ThreadPool &pool = ThreadPool::global()) : pool_(pool) {}
+  TaskGroup(const TaskGroup &) = delete;
+  TaskGroup &operator=(const TaskGroup &) = delete;
+  ~TaskGroup() {
+    cancel();
+    drain();
+  }
+
+  template <std::invocable F> void run(F &&task) {
+    pending_.fetch_add(1, std::memory_order_relaxed);
+    // The group may be gone as soon as its last task is counted down, so
+    // that task reaches the pool through its own reference
+    pool_.submit([this, &pool = pool_, task = std::forward<F>(task)]() mutable {
+      if (!cancelled()) {
+        try {
+          task();
+        } catch (...) {
+          std::lock_guard lock(error_mutex_);
+          if (!error_) {
+            error_ = std::current_exception();
+          }
+          cancel();
+        }
+      }
+      if (pending_.fetch_sub(1, std::memory_order_release) == 1) {
+        pool.notifyAll();
+      }
+    });
+  }
+
+  // Helps running queued tasks until every task of the group is done
+  void wait() {
+    drain();
+    if (error_) {
+      std::rethrow_exception(std::exchange(error_, nullptr));
+    }
+  }
+
+  void cancel() { cancelled_.store(true, std::memory_order_relaxed); }
+  bool cancelled() const {
+    return cancelled_.load(std::memory_order_relaxed);
+  }
+
+private:
+  // Runs queued tasks while the group is busy and sleeps when there are
+  // none, until its last task wakes it
+  void drain() {
+    auto done = [this] {
+      return pending_.load(std::memory_order_acquire) == 0;
+    };
+    while (!done()) {
+      if (!pool_.runOne()) {
+        pool_.waitForWork(done);
+      }
+    }
+  }
+
+  ThreadPool &pool_;
+  std::atomic<size_t> pending_{0};
+  std::atomic<bool> cancelled_{false};
+  std::mutex error_mutex_;
+  std::exception_ptr error_;
+};
+
+// Iterations per task: the given grain, or enough for about eight tasks per
+// thread so uneven iterations still balance
+inline size_t grainFor(const ThreadPool &pool, size_t count, size_t grain) {
+  return grain > 0 ? grain : std::max<size_t>(1, count / (pool.size() * 8));
+}
+
+// Runs body(i) for every i in [begin, end). A body returning bool stops the
+// loop early by returning false: iterations not yet started are skipped and
+// parallel_for returns false.
+template <std::integral Index, typename Body>
+bool parallel_for(ThreadPool &pool, Index begin, Index end, Body &&body,
+                  size_t grain = 0) {
+  if (end <= begin) {
+    return true;
+  }
+  constexpr bool Stoppable =
+      std::is_same_v<std::invoke_result_t<Body &, Index>, bool>;
+  const auto count = static_cast<size_t>(end - begin);
+  grain = grainFor(pool, count, grain);
+  TaskGroup group(pool);
+  for (size_t first = 0; first < count; first += grain) {
+    const Index lo = begin + static_cast<Index>(first);
+    const Index hi =
+        begin + static_cast<Index>(std::min(count, first + grain));
+    group.run([&body, &group, lo, hi] {
+      for (Index i = lo; i < hi; ++i) {
+        if constexpr (Stoppable) {
+          if (group.cancelled() || !body(i)) {
+            group.cancel();
+            return;
+          }
+        } else {
+          body(i);
+        }
+      }
+    });
+  }
+  group.wait();
+  return !group.cancelled();
+}
+
+template <std::integral Index, typename Body>
+bool parallel_for(Index begin, Index end, Body &&body, size_t grain = 0) {
+  return parallel_for(ThreadPool::global(), begin, end,
+                      std::forward<Body>(body), grain);
+}
+
+// Splits [begin, end) into subranges, maps each with body(lo, hi) -> T and
+// folds the results with combine in range order, so the result does not
+// depend on scheduling even for a non-commutative combine.
+template <std::integral Index, typename T, typename Body, typename Combine>
+  requires std::invocable<Body &, Index, Index> &&
+           std::invocable<Combine &, T, T>
+T parallel_reduce(ThreadPool &pool, Index begin, Index end, T identity,
+                  Body &&body, Combine &&combine, size_t grain = 0) {
+  if (end <= begin) {
+    return identity;
+  }
+  const auto count = static_cast<size_t>(end - begin);
+  grain = grainFor(pool, count, grain);
+  std::vector<std::optional<T>> partial((count + grain - 1) / grain);
+  TaskGroup group(pool);
+  for (size_t chunk = 0; chunk < partial.size(); ++chunk) {
+    const Index lo = begin + static_cast<Index>(chunk * grain);
+    const Index hi =
+        begin + static_cast<Index>(std::min(count, (chunk + 1) * grain));
+    group.run([&body, &partial, chunk, lo, hi] {
+      partial[chunk].emplace(body(lo, hi));
+    });
+  }
+  group.wait();
+  T result = std::move(identity);
+  for (auto &value : partial) {
+    result = combine(std::move(result), std::move(*value));
+  }
+  return result;
+}
+
+template <std::integral Index, typename T, typename Body, typename Combine>
+  requires std::invocable<Body &, Index, Index> &&
+           std::invocable<Combine &, T, T>
+T parallel_reduce(Index begin, Index end, T identity, Body &&body,
+                  Combine &&combine, size_t grain = 0) {
+  return parallel_reduce(ThreadPool::global(), begin, end, std::move(identity),
+                         std::forward<Body>(body),
+                         std::forward<Combine>(combine), grain);
+}
+
+inline void printPoolStats(std::FILE *out,
+                           const ThreadPoolStats &stats =
+                               ThreadPool::global().stats()) {
+  std::println(out,
+               "thread pool: {} threads, {} tasks, {} stolen, "
+               "{:.1f} ms busy, {:.0f}% utilisation",
+               stats.threads, stats.tasks, stats.steals, stats.busy_ms,
+               stats.utilisation() * 100.0);
+}
+
+} // namespace puzzles::common
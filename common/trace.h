@@ -0,0 +1,211 @@
+#pragma once
+
+// Scoped hot-path tracing. Configure with -DPUZZLES_TRACE=ON to record
+// PUZZLES_TRACE_SCOPE regions; the events are written as Chrome trace JSON
+// (open in Perfetto or chrome://tracing) when the process exits, to
+// $PUZZLES_TRACE_FILE or ./trace.json. With PUZZLES_PERF_COUNTERS the same
+// scopes also collect hardware counters (common/perf_counters.h), with
+// PUZZLES_COUNT_ALLOCS their heap allocations (common/alloc_counter.h).
+// Without any of them the macros expand to nothing.
+
+#include "alloc_counter.h"
+#include "perf_counters.h"
+#include <string_view>
+
+#ifdef PUZZLES_TRACE
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <print>
+#include <string_view>
+#include <vector>
+
+namespace puzzles::common {
+
+struct TraceEvent {
+  std::string_view name; // must outlive the process, usually a literal
+  int64_t start_ns;
+  int64_t duration_ns;
+};
+
+// Events of one thread; only that thread appends, so recording takes no lock
+struct TraceTrack {
+  size_t tid;
+  std::vector<TraceEvent> events;
+};
+
+class Tracer {
+public:
+  static Tracer &instance() {
+    static Tracer tracer{};
+    return tracer;
+  }
+
+  Tracer(const Tracer &) = delete;
+  Tracer &operator=(const Tracer &) = delete;
+  ~Tracer() {
+    const char *path = std::getenv("PUZZLES_TRACE_FILE");
+    write(path && *path ? path : "trace.json");
+  }
+
+  // Track of the calling thread, created on its first event
+  TraceTrack &track() {
+    thread_local TraceTrack *current = nullptr;
+    if (!current) {
+      std::lock_guard lock(mutex_);
+      tracks_.push_back(std::make_unique<TraceTrack>());
+      current = tracks_.back().get();
+      current->tid = tracks_.size();
+      current->events.reserve(1024);
+    }
+    return *current;
+  }
+
+  int64_t now() const {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now() - origin_)
+        .count();
+  }
+
+  // Chrome trace event format: complete ("X") events in microseconds and
+  // one thread_name record per track
+  bool write(const char *path) {
+    std::lock_guard lock(mutex_);
+    std::FILE *out = std::fopen(path, "w");
+    if (!out) {
+      std::println(stderr, "Cannot write trace file {}", path);
+      return false;
+    }
+    std::print(out, "{{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+    const char *separator = "\n";
+    for (const auto &track : tracks_) {
+      std::print(out,
+                 "{}{{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,"
+                 "\"tid\":{},\"args\":{{\"name\":\"thread {}\"}}}}",
+                 separator, track->tid, track->tid);
+      separator = ",\n";
+      for (const auto &event : track->events) {
+        std::print(out, "{}{{\"ph\":\"X\",\"name\":\"", separator);
+        for (char c : event.name) {
+          if (c == '"' || c == '\\') {
+            std::fputc('\\', out);
+          }
+          std::fputc(c, out);
+        }
+        std::print(out,
+                   "\",\"pid\":1,\"tid\":{},\"ts\":{:.3f},\"dur\":{:.3f}}}",
+                   track->tid, event.start_ns / 1e3, event.duration_ns / 1e3);
+      }
+    }
+    std::print(out, "\n]}}\n");
+    return std::fclose(out) == 0;
+  }
+
+private:
+  Tracer() = default;
+
+  std::chrono::steady_clock::time_point origin_ =
+      std::chrono::steady_clock::now();
+  std::mutex mutex_;
+  std::vector<std::unique_ptr<TraceTrack>> tracks_;
+};
+
+// Records [construction, end()) as one event on the current thread's track
+class TraceScope {
+public:
+  explicit TraceScope(std::string_view name)
+      : name_(name), start_(Tracer::instance().now()) {}
+  TraceScope(const TraceScope &) = delete;
+  TraceScope &operator=(const TraceScope &) = delete;
+  ~TraceScope() { end(); }
+
+  void end() {
+    if (!ended_) {
+      ended_ = true;
+      auto &tracer = Tracer::instance();
+      tracer.track().events.push_back(
+          {name_, start_, tracer.now() - start_});
+    }
+  }
+
+private:
+  std::string_view name_;
+  int64_t start_;
+  bool ended_ = false;
+};
+
+} // namespace puzzles::common
+
+#endif
+
+#if defined(PUZZLES_TRACE) || defined(PUZZLES_PERF_COUNTERS) ||             \
+    defined(PUZZLES_COUNT_ALLOCS)
+
+namespace puzzles::common {
+
+// Stands in for a kind of instrumentation that is configured off
+struct NoPhaseScope {
+  explicit NoPhaseScope(std::string_view) {}
+  void end() {}
+};
+
+#ifndef PUZZLES_TRACE
+using TraceScope = NoPhaseScope;
+#endif
+#ifndef PUZZLES_PERF_COUNTERS
+using PerfScope = NoPhaseScope;
+#endif
+#ifndef PUZZLES_COUNT_ALLOCS
+using AllocationScope = NoPhaseScope;
+#endif
+
+// One instrumented phase: any of a trace event, a counter sample and the
+// phase's heap allocations
+class PhaseScope {
+public:
+  explicit PhaseScope(std::string_view name)
+      : trace_(name), perf_(name), allocs_(name) {}
+  PhaseScope(const PhaseScope &) = delete;
+  PhaseScope &operator=(const PhaseScope &) = delete;
+  ~PhaseScope() { end(); }
+
+  void end() {
+    allocs_.end();
+    perf_.end();
+    trace_.end();
+  }
+
+private:
+  // Nested by cost: neither the counters nor the allocation count see the
+  // trace bookkeeping, the allocation count misses the counters' own
+  [[no_unique_address]] TraceScope trace_;
+  [[no_unique_address]] PerfScope perf_;
+  [[no_unique_address]] AllocationScope allocs_;
+};
+
+} // namespace puzzles::common
+
+#define PUZZLES_TRACE_CONCAT_(a, b) a##b
+#define PUZZLES_TRACE_CONCAT(a, b) PUZZLES_TRACE_CONCAT_(a, b)
+// Traces the rest of the enclosing block
+#define PUZZLES_TRACE_SCOPE(name)                                              \
+  ::puzzles::common::PhaseScope PUZZLES_TRACE_CONCAT(trace_scope_,             \
+                                                     __LINE__) {               \
+    name                                                                       \
+  }
+// Traces from here until PUZZLES_TRACE_END(var), for sequential phases that
+// share one block
+#define PUZZLES_TRACE_BEGIN(var, name) ::puzzles::common::PhaseScope var{name}
+#define PUZZLES_TRACE_END(var) var.end()
+
+#else
+
+#define PUZZLES_TRACE_SCOPE(name) static_cast<void>(0)
+#define PUZZLES_TRACE_BEGIN(var, name) static_cast<void>(0)
+#define PUZZLES_TRACE_END(var) static_cast<void>(0)
+
+#endif
@@ -0,0 +1,163 @@
+/*
+ * Single-process puzzle runner
+ * All days are linked in as registered solvers and run inside this process,
+ * one after another or in parallel across cores, with per-day timings.
+ * Usage:
+ *   puzzles [--list] [--parallel] [--jobs N] [name[=input[,arg...]] ...]
+ * Without names every registered day is run.
+ */
+
+#include "../common/alloc_counter.h"
+#include "../common/common.h"
+#include "../common/registry.h"
+#include "../common/thread_pool.h"
+#include "../common/trace.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <print>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+namespace pc = puzzles::common;
+
+struct Job {
+  const pc::Solver *solver = nullptr;
+  std::vector<std::string> argv; // input file and extra arguments
+  int status = 0;
+  double elapsed_ms = 0.0;
+  uint64_t allocations = 0; // includes other jobs' with --parallel
+  std::string output;
+};
+
+// Run one solver with its answers captured into job.output
+void runJob(Job &job) {
+  char *buffer = nullptr;
+  size_t size = 0;
+  std::FILE *out = ::open_memstream(&buffer, &size);
+  if (!out) {
+    job.status = 1;
+    job.output = "cannot capture solver output\n";
+    return;
+  }
+
+  std::vector<char *> argv;
+  for (auto &arg : job.argv) {
+    argv.push_back(arg.data());
+  }
+  auto ctx = pc::makeContext(*job.solver, argv, out);
+
+  const auto allocations = pc::allocationStats().allocations;
+  auto start = std::chrono::steady_clock::now();
+  PUZZLES_TRACE_BEGIN(solve_scope, job.solver->name);
+  job.status = job.solver->solve(ctx);
+  PUZZLES_TRACE_END(solve_scope);
+  job.allocations = pc::allocationStats().allocations - allocations;
+  job.elapsed_ms = std::chrono::duration<double, std::milli>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+
+  std::fclose(out);
+  job.output.assign(buffer, size);
+  std::free(buffer);
+}
+} // namespace
+
+int main(int argc, char *argv[]) {
+  bool parallel = false;
+  size_t jobs_count = std::max(1u, std::thread::hardware_concurrency());
+  std::vector<Job> jobs;
+
+  for (int i = 1; i < argc; ++i) {
+    std::string_view arg = argv[i];
+    if (arg == "--list") {
+      for (const auto &solver : pc::solvers()) {
+        std::println("{:<16} {}", solver.name, solver.default_input.string());
+      }
+      return 0;
+    } else if (arg == "--parallel") {
+      parallel = true;
+    } else if (arg == "--jobs" && i + 1 < argc) {
+      jobs_count = std::max(1, std::stoi(argv[++i]));
+      parallel = true;
+    } else {
+      auto eq = arg.find('=');
+      const auto *solver = pc::findSolver(arg.substr(0, eq));
+      if (!solver) {
+        std::println(stderr, "Unknown puzzle: {}", arg.substr(0, eq));
+        return 1;
+      }
+      Job job{};
+      job.solver = solver;
+      if (eq != std::string_view::npos) {
+        auto params = arg.substr(eq + 1);
+        for (size_t begin = 0; begin <= params.size();) {
+          size_t end = std::min(params.find(',', begin), params.size());
+          job.argv.emplace_back(params.substr(begin, end - begin));
+          begin = end + 1;
+        }
+      }
+      jobs.push_back(std::move(job));
+    }
+  }
+
+  if (jobs.empty()) {
+    for (const auto &solver : pc::solvers()) {
+      Job job{};
+      job.solver = &solver;
+      jobs.push_back(std::move(job));
+    }
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  if (parallel && jobs.size() > 1) {
+    std::atomic<size_t> next{0};
+    std::vector<std::jthread> workers;
+    for (size_t w = 0; w < std::min(jobs_count, jobs.size()); ++w) {
+      workers.emplace_back([&] {
+        for (size_t idx = next++; idx < jobs.size(); idx = next++) {
+          runJob(jobs[idx]);
+        }
+      });
+    }
+  } else {
+    for (auto &job : jobs) {
+      runJob(job);
+    }
+  }
+  const double total_ms = std::chrono::duration<double, std::milli>(
+                              std::chrono::steady_clock::now() - start)
+                              .count();
+
+  int failures = 0;
+  for (const auto &job : jobs) {
+    std::println("== {} ({:.3f} ms)", job.solver->name, job.elapsed_ms);
+    std::print("{}", job.output);
+    failures += job.status != 0 ? 1 : 0;
+  }
+
+  std::println("");
+  std::print("{:<16} {:>12} {:>8}", "puzzle", "time ms", "status");
+#ifdef PUZZLES_COUNT_ALLOCS
+  std::print(" {:>12}", "allocations");
+#endif
+  std::println("");
+  for (const auto &job : jobs) {
+    std::print("{:<16} {:>12.3f} {:>8}", job.solver->name, job.elapsed_ms,
+               job.status);
+#ifdef PUZZLES_COUNT_ALLOCS
+    std::print(" {:>12}", job.allocations);
+#endif
+    std::println("");
+  }
+  std::println("{:<16} {:>12.3f} {:>8}",
+               parallel ? "total (parallel)" : "total", total_ms, failures);
+  if (auto stats = pc::ThreadPool::global().stats(); stats.tasks > 0) {
+    pc::printPoolStats(stdout, stats);
+  }
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,947 @@
+/*
+ * Differential tests
+ * The existing implementations serve as reference oracles for the faster
+ * engines that replace them. Every property generates random cases, from
+ * the input generators where a day's input is needed, runs the reference
+ * and the engines on them and compares the results. A mismatching case is
+ * shrunk, first by dropping lines and then characters for as long as the
+ * mismatch persists, and printed with what differed.
+ * Usage:
+ *   differential --list
+ *   differential [--seed N] [--cases N] [property...]
+ * Without properties every one of them runs. Registered with ctest as one
+ * test per property; nothing touches the network.
+ */
+
+#include "../Day1/dial.h"
+#include "../Day2/id_patterns.h"
+#include "../Day5/inventory.h"
+#include "../Day9/polygon.h"
+#include "../common/common.h"
+#include "../common/cpu_dispatch.h"
+#include "../common/grid.h"
+#include "../common/stream.h"
+#include "../tools/generators.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <limits>
+#include <optional>
+#include <print>
+#include <span>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <unistd.h>
+
+namespace {
+namespace pc = puzzles::common;
+namespace gen = puzzles::generators;
+
+using gen::Rng;
+
+// What differed, or nullopt when the engines agree with the reference
+using Mismatch = std::optional<std::string>;
+
+struct Property {
+  std::string_view name;
+  std::string_view description;
+  // A case of roughly `size` lines or elements
+  std::string (*generate)(Rng &rng, size_t size);
+  Mismatch (*check)(std::string_view text);
+};
+
+std::vector<std::string_view> splitLines(std::string_view text) {
+  std::vector<std::string_view> lines;
+  pc::forEachLine(text, [&lines](std::string_view line) {
+    lines.push_back(line);
+    return true;
+  });
+  return lines;
+}
+
+// Input of a day from its generator, with every parameter scaled down to at
+// most `size` so cases stay small enough to shrink
+std::string generated(std::string_view day, Rng &rng, size_t size) {
+  const auto *generator = gen::findGenerator(day);
+  gen::Params params(generator->defaults);
+  for (const auto &[name, value] : generator->defaults) {
+    params.set(name, gen::uniform(rng, 1, std::min<uint64_t>(value, size)));
+  }
+  return gen::generateText(*generator, rng, params);
+}
+
+// Comma separated values, for messages
+template <typename Range> std::string listed(const Range &values) {
+  std::string text = "[";
+  for (const auto &value : values) {
+    text += std::format("{}{}", text.size() > 1 ? ", " : "", value);
+  }
+  return text + "]";
+}
+
+// Variants of a kernel that the CPU can run, with their tier names
+template <typename Fn>
+using NamedVariants = std::vector<std::pair<std::string_view, Fn *>>;
+
+template <typename Fn>
+NamedVariants<Fn> runnableVariants(const pc::KernelVariants<Fn> &variants) {
+  using enum pc::CpuTier;
+  NamedVariants<Fn> runnable;
+  for (auto tier : {SSE2, AVX2, AVX512}) {
+    Fn *variant = variants.select(tier);
+    if (tier <= pc::detectCpuTier() && variant != variants.scalar &&
+        std::ranges::find(runnable, variant,
+                          &NamedVariants<Fn>::value_type::second) ==
+            runnable.end()) {
+      runnable.emplace_back(pc::cpuTierName(tier), variant);
+    }
+  }
+  return runnable;
+}
+
+// ---------------------------------------------------------------------------
+// Day 1: the chunked prefix scan and the window index against applying the
+// moves one by one
+// ---------------------------------------------------------------------------
+
+std::string generateMoves(Rng &rng, size_t size) {
+  std::string text = generated("day1", rng, size);
+  // Moves of no distance, exact turns and ones far past the old limit
+  for (uint64_t n = gen::uniform(rng, 0, size / 4); n > 0; --n) {
+    uint64_t distance = gen::uniform(rng, 0, 2) == 0
+                            ? 100 * gen::uniform(rng, 0, 3)
+                            : gen::uniform(rng, 0, gen::pow10(18));
+    text += std::format("{}{}\n", gen::chance(rng, 50) ? 'L' : 'R', distance);
+  }
+  return text;
+}
+
+Mismatch checkDialScan(std::string_view text) {
+  using namespace puzzles::day1;
+  std::vector<int64_t> parsed;
+  DecodedMoves moves;
+  for (auto line : splitLines(text)) {
+    if (auto move = parseMove(line)) {
+      parsed.push_back(*move);
+      moves.push_back(*move);
+    }
+  }
+  // Every start position, so each entry of the summaries is compared
+  for (int start = 0; start < TRACK_SIZE; ++start) {
+    Dial reference{.position = start};
+    for (auto move : parsed) {
+      applyMove(reference, move);
+    }
+    for (size_t grain : {1, 3, 64}) {
+      Dial dial = turnDial(Dial{.position = start}, moves, grain);
+      if (dial.position != reference.position ||
+          dial.zero_stops != reference.zero_stops ||
+          dial.zero_passes != reference.zero_passes) {
+        return std::format(
+            "from {} in chunks of {}: scan {} {} at {}, moves {} {} at {}",
+            start, grain, dial.zero_stops, dial.zero_passes, dial.position,
+            reference.zero_stops, reference.zero_passes, reference.position);
+      }
+    }
+  }
+  return std::nullopt;
+}
+
+// Every window of the moves, from a few start positions, against replaying
+// the window move by move
+Mismatch checkDialIndex(std::string_view text) {
+  using namespace puzzles::day1;
+  std::vector<int64_t> parsed;
+  MoveLog log;
+  for (auto line : splitLines(text)) {
+    if (auto move = parseMove(line)) {
+      parsed.push_back(*move);
+      log.push_back(*move);
+    }
+  }
+  for (size_t block_size : {1, 4, 16}) {
+    const DialIndex index(log, block_size);
+    for (int start : {0, 1, 50, 99}) {
+      for (size_t first = 0; first <= parsed.size(); ++first) {
+        Dial reference{.position = start};
+        for (size_t last = first;; ++last) {
+          auto dial = index.query(first, last, start);
+          if (!dial || dial->position != reference.position ||
+              dial->zero_stops != reference.zero_stops ||
+              dial->zero_passes != reference.zero_passes) {
+            return std::format(
+                "moves [{}, {}) from {} in blocks of {}: index {}, "
+                "moves {} {} at {}",
+                first, last, start, block_size,
+                dial ? std::format("{} {} at {}", dial->zero_stops,
+                                   dial->zero_passes, dial->position)
+                     : "none",
+                reference.zero_stops, reference.zero_passes,
+                reference.position);
+          }
+          if (last == parsed.size()) {
+            break;
+          }
+          applyMove(reference, parsed[last]);
+        }
+      }
+    }
+  }
+  return std::nullopt;
+}
+
+// ---------------------------------------------------------------------------
+// Day 2: the string comparison of the two halves against the arithmetic
+// is_valid, and the closed form and table sums against summing the string
+// predicates
+// ---------------------------------------------------------------------------
+
+std::string generateIds(Rng &rng, size_t size) {
+  std::string text;
+  for (size_t i = 0; i < size; ++i) {
+    // Half the IDs repeat their first half, the interesting case
+    uint64_t digits = gen::uniform(rng, 1, 18);
+    uint64_t id = gen::uniform(rng, 0, gen::pow10(digits) - 1);
+    if (gen::chance(rng, 50)) {
+      uint64_t half = id % gen::pow10(gen::uniform(rng, 1, 9));
+      id = half * gen::pow10(std::to_string(half).size()) + half;
+      id += gen::chance(rng, 20) ? gen::uniform(rng, 0, 2) - 1 : 0;
+    }
+    text += std::format("{}\n", id);
+  }
+  return text;
+}
+
+Mismatch checkIdHalves(std::string_view text) {
+  for (auto line : splitLines(text)) {
+    auto id = pc::to_unsigned<uint64_t>(line);
+    if (!id) {
+      continue;
+    }
+    bool reference = puzzles::day2::is_invalid(*id);
+    if (reference == puzzles::day2::is_valid(*id)) {
+      return std::format("id {}: is_invalid {}, is_valid {}", *id, reference,
+                         !reference);
+    }
+  }
+  return std::nullopt;
+}
+
+// Ranges "first-last" of up to a few thousand IDs, around doubled IDs of
+// every length and up to the end of uint64_t
+std::string generateIdRanges(Rng &rng, size_t size) {
+  std::string text;
+  for (size_t i = 0; i < size; ++i) {
+    const uint64_t k = gen::uniform(rng, 1, 10);
+    const uint64_t multiplier = gen::pow10(k) + 1;
+    const uint64_t limit = std::numeric_limits<uint64_t>::max() / multiplier;
+    const uint64_t half =
+        gen::uniform(rng, gen::pow10(k - 1), std::min(gen::pow10(k), limit));
+    uint64_t center = half * multiplier;
+    if (gen::chance(rng, 10)) {
+      center = std::numeric_limits<uint64_t>::max() - gen::uniform(rng, 0, 9);
+    }
+    const uint64_t below =
+        gen::uniform(rng, 0, std::min<uint64_t>(center, 3000));
+    const uint64_t above =
+        gen::uniform(rng, 0, std::min<uint64_t>(~center, 3000));
+    text += std::format("{}-{}\n", center - below, center + above);
+  }
+  return text;
+}
+
+Mismatch checkDoubledSums(std::string_view text) {
+  for (auto line : splitLines(text)) {
+    std::array<uint64_t, 2> range{};
+    auto fields = pc::parse_integers(line, std::span(range));
+    if (!fields || *fields != range.size() || range[0] > range[1]) {
+      continue;
+    }
+    uint64_t reference = 0;
+    for (uint64_t id = range[0];; ++id) {
+      reference += puzzles::day2::is_invalid(id) ? id : 0;
+      if (id == range[1]) {
+        break;
+      }
+    }
+    const uint64_t sum = puzzles::day2::sum_doubled_ids(range[0], range[1]);
+    if (sum != reference) {
+      return std::format("{}-{}: closed form {}, is_invalid {}", range[0],
+                         range[1], sum, reference);
+    }
+  }
+  return std::nullopt;
+}
+
+// Ranges "first-last" of up to a few thousand IDs, around IDs of every length
+// that repeat a block of every length dividing it
+std::string generateRepeatedRanges(Rng &rng, size_t size) {
+  std::string text;
+  for (size_t i = 0; i < size; ++i) {
+    const int digits = static_cast<int>(gen::uniform(rng, 2, 20));
+    int period = static_cast<int>(gen::uniform(rng, 1, digits / 2));
+    while (digits % period != 0) {
+      --period;
+    }
+    const uint64_t multiplier =
+        puzzles::day2::repeat_multiplier(digits, period);
+    const uint64_t limit = std::numeric_limits<uint64_t>::max() / multiplier;
+    const uint64_t block_min = gen::pow10(period - 1);
+    uint64_t center = std::numeric_limits<uint64_t>::max() -
+                      gen::uniform(rng, 0, 9);
+    if (block_min <= limit) {
+      center = gen::uniform(rng, block_min,
+                            std::min(gen::pow10(period) - 1, limit)) *
+               multiplier;
+    }
+    const uint64_t below =
+        gen::uniform(rng, 0, std::min<uint64_t>(center, 3000));
+    const uint64_t above =
+        gen::uniform(rng, 0, std::min<uint64_t>(~center, 3000));
+    text += std::format("{}-{}\n", center - below, center + above);
+  }
+  return text;
+}
+
+Mismatch checkRepeatedSums(std::string_view text) {
+  for (auto line : splitLines(text)) {
+    std::array<uint64_t, 2> range{};
+    auto fields = pc::parse_integers(line, std::span(range));
+    if (!fields || *fields != range.size() || range[0] > range[1]) {
+      continue;
+    }
+    uint64_t reference = 0;
+    for (uint64_t id = range[0];; ++id) {
+      reference += puzzles::day2::is_invalid2(id) ? id : 0;
+      if (id == range[1]) {
+        break;
+      }
+    }
+    const uint64_t table = puzzles::day2::sum_repeated_ids(range[0], range[1]);
+    const uint64_t closed =
+        puzzles::day2::sum_repeated_ids_closed_form(range[0], range[1]);
+    if (table != reference || closed != reference) {
+      return std::format("{}-{}: table {}, closed form {}, is_invalid2 {}",
+                         range[0], range[1], table, closed, reference);
+    }
+  }
+  return std::nullopt;
+}
+
+// The scalar and eight wide digit kernels against the string predicates,
+// over every ID of the ranges
+Mismatch checkDigitKernels(std::string_view text) {
+  namespace day2 = puzzles::day2;
+  for (auto line : splitLines(text)) {
+    std::array<uint64_t, 2> range{};
+    auto fields = pc::parse_integers(line, std::span(range));
+    if (!fields || *fields != range.size() || range[0] > range[1]) {
+      continue;
+    }
+    for (uint64_t first = range[0]; first <= range[1]; first += 8) {
+      const auto doubled = day2::check_ids8<day2::DoubledKernel>(first);
+      const auto repeated = day2::check_ids8<day2::RepeatedKernel>(first);
+      for (uint64_t i = 0; i < 8 && first + i >= first; ++i) {
+        const uint64_t id = first + i;
+        const bool half = day2::is_invalid(id);
+        const bool block = day2::is_invalid2_string(id);
+        if (half == day2::is_valid(id) || block != day2::is_invalid2(id) ||
+            half != ((doubled >> i) & 1) || block != ((repeated >> i) & 1)) {
+          return std::format("id {}: is_invalid {}, is_invalid2_string {}, "
+                             "is_valid {}, is_invalid2 {}, eight wide {} {}",
+                             id, half, block, day2::is_valid(id),
+                             day2::is_invalid2(id), (doubled >> i) & 1,
+                             (repeated >> i) & 1);
+        }
+      }
+      if (range[1] - first < 8) {
+        break;
+      }
+    }
+  }
+  return std::nullopt;
+}
+
+// ---------------------------------------------------------------------------
+// Integer parsing: std::from_chars against the SWAR parser, for every width
+// ---------------------------------------------------------------------------
+
+std::string generateNumbers(Rng &rng, size_t size) {
+  constexpr std::string_view limits[] = {"255", "65535", "4294967295",
+                                         "18446744073709551615"};
+  std::string text;
+  for (size_t i = 0; i < size; ++i) {
+    std::string number;
+    switch (gen::uniform(rng, 0, 3)) {
+    case 0: // around the limit of a width
+      number = limits[gen::uniform(rng, 0, 3)];
+      number.back() = static_cast<char>('0' + gen::uniform(rng, 0, 9));
+      break;
+    case 1: // leading zeros
+      number = std::string(gen::uniform(rng, 1, 12), '0') +
+               std::to_string(gen::uniform(rng, 0, 99999));
+      break;
+    default:
+      for (uint64_t n = gen::uniform(rng, 0, 22); n > 0; --n) {
+        number += static_cast<char>('0' + gen::uniform(rng, 0, 9));
+      }
+    }
+    if (gen::chance(rng, 10) && !number.empty()) {
+      number[gen::uniform(rng, 0, number.size() - 1)] = "x-+ /:"[
+          gen::uniform(rng, 0, 5)];
+    }
+    text += number + "\n";
+  }
+  return text;
+}
+
+template <pc::UnsignedInteger T>
+Mismatch compareParsers(std::string_view line) {
+  auto reference = pc::to_unsigned<T>(line);
+  auto swar = pc::to_unsigned_swar<T>(line);
+  if (reference == swar) {
+    return std::nullopt;
+  }
+  auto describe = [](const std::expected<T, std::errc> &value) {
+    return value ? std::to_string(*value)
+                 : std::make_error_code(value.error()).message();
+  };
+  return std::format("\"{}\" as {}-bit: from_chars {}, swar {}", line,
+                     8 * sizeof(T), describe(reference), describe(swar));
+}
+
+Mismatch checkParsers(std::string_view text) {
+  for (auto line : splitLines(text)) {
+    for (auto mismatch :
+         {compareParsers<uint8_t>(line), compareParsers<uint16_t>(line),
+          compareParsers<uint32_t>(line), compareParsers<uint64_t>(line)}) {
+      if (mismatch) {
+        return mismatch;
+      }
+    }
+  }
+  return std::nullopt;
+}
+
+// ---------------------------------------------------------------------------
+// Tokenizer: parse_integers against std::istringstream, and the vector
+// class scans against the scalar one
+// ---------------------------------------------------------------------------
+
+// Day inputs full of numbers and separators, with some bytes replaced
+std::string generateTokens(Rng &rng, size_t size) {
+  constexpr std::string_view days[] = {"day2", "day5", "day6",
+                                       "day8", "day10", "day12"};
+  std::string text =
+      generated(days[gen::uniform(rng, 0, std::size(days) - 1)], rng, size);
+  for (auto &c : text) {
+    if (c != '\n' && gen::chance(rng, 2)) {
+      c = " \t-,[({x0123456789"[gen::uniform(rng, 0, 17)];
+    }
+  }
+  return text;
+}
+
+// Reference: every character that is neither a digit nor a sign turned
+// into a space, then read with a stream. Empty on a field out of range.
+template <std::integral T>
+std::optional<std::vector<T>> streamIntegers(std::string_view line) {
+  std::string spaced(line);
+  for (size_t i = 0; i < line.size(); ++i) {
+    bool sign = std::signed_integral<T> && line[i] == '-' &&
+                i + 1 < line.size() && pc::is_digit(line[i + 1]) &&
+                (i == 0 || !pc::is_digit(line[i - 1]));
+    if (!pc::is_digit(line[i]) && !sign) {
+      spaced[i] = ' ';
+    }
+  }
+  std::istringstream in(spaced);
+  std::vector<T> values;
+  T value{};
+  while (in >> value) {
+    values.push_back(value);
+  }
+  if (!in.eof()) {
+    return std::nullopt;
+  }
+  return values;
+}
+
+template <std::integral T> Mismatch compareTokens(std::string_view line) {
+  std::vector<T> fields(line.size());
+  auto count = pc::parse_integers(line, std::span(fields));
+  auto reference = streamIntegers<T>(line);
+  if (count.has_value() == reference.has_value() &&
+      (!count || std::ranges::equal(std::span(fields).first(*count),
+                                    *reference))) {
+    return std::nullopt;
+  }
+  return std::format(
+      "\"{}\" as {}: parse_integers {}, istringstream {}", line,
+      std::signed_integral<T> ? "int64" : "uint64",
+      count ? listed(std::span(fields).first(*count))
+            : std::make_error_code(count.error()).message(),
+      reference ? listed(*reference) : "out of range");
+}
+
+Mismatch checkTokens(std::string_view text) {
+  for (auto line : splitLines(text)) {
+    if (auto mismatch = compareTokens<int64_t>(line)) {
+      return mismatch;
+    }
+    if (auto mismatch = compareTokens<uint64_t>(line)) {
+      return mismatch;
+    }
+  }
+  return std::nullopt;
+}
+
+template <pc::detail::CharClass Class>
+Mismatch compareScans(std::string_view text, std::string_view name) {
+  using ScanFn = size_t(std::string_view, size_t);
+  const pc::KernelVariants<ScanFn> scans{
+      .scalar = pc::detail::find_class_scalar<Class>,
+#ifdef PUZZLES_HAS_SSE2
+      .sse2 = pc::detail::find_class_sse2<Class>,
+#endif
+#ifdef PUZZLES_HAS_CPU_DISPATCH
+      .avx2 = pc::detail::find_class_avx2<Class>,
+      .avx512 = pc::detail::find_class_avx512<Class>,
+#endif
+  };
+  for (size_t pos = 0; pos <= text.size(); ++pos) {
+    size_t reference = scans.scalar(text, pos);
+    for (const auto &[tier, scan] : runnableVariants(scans)) {
+      size_t found = scan(text, pos);
+      if (found != reference) {
+        return std::format("{} scan from {}: scalar {}, {} {}", name, pos,
+                           static_cast<ptrdiff_t>(reference), tier,
+                           static_cast<ptrdiff_t>(found));
+      }
+    }
+  }
+  return std::nullopt;
+}
+
+Mismatch checkScans(std::string_view text) {
+  using enum pc::detail::CharClass;
+  for (auto mismatch : {compareScans<Digit>(text, "digit"),
+                        compareScans<NonDigit>(text, "non-digit"),
+                        compareScans<Space>(text, "space"),
+                        compareScans<NonSpace>(text, "non-space"),
+                        compareScans<GroupOpen>(text, "group")}) {
+    if (mismatch) {
+      return mismatch;
+    }
+  }
+  return std::nullopt;
+}
+
+// ---------------------------------------------------------------------------
+// Day 4 neighbour counting: the vector variants against the scalar stencil
+// ---------------------------------------------------------------------------
+
+std::string generateGrid(Rng &rng, size_t size) {
+  return generated("day4", rng, size * 4);
+}
+
+Mismatch checkSparseCells(std::string_view text) {
+  const pc::KernelVariants<pc::detail::SparseCellsFn> kernels{
+      .scalar = pc::detail::sparse_cells_scalar,
+#ifdef PUZZLES_HAS_SSE2
+      .sse2 = pc::detail::sparse_cells_sse2,
+#endif
+#ifdef PUZZLES_HAS_CPU_DISPATCH
+      .avx2 = pc::detail::sparse_cells_avx2,
+      .avx512 = pc::detail::sparse_cells_avx512,
+#endif
+  };
+  auto grid = pc::Grid<char>::fromText(text, 1, '.');
+  std::vector<int> reference(grid.cols());
+  std::vector<int> found(grid.cols());
+  for (int row = 0; row < grid.rows(); ++row) {
+    // Every split of the row, as tiles cut it
+    for (int begin = 0; begin < grid.cols(); begin += 7) {
+      const char *rows[] = {&grid(row - 1, 0), &grid(row, 0),
+                            &grid(row + 1, 0)};
+      for (int limit : {1, 4, 8}) {
+        size_t count = kernels.scalar(rows[0], rows[1], rows[2], begin,
+                                      grid.cols(), '@', limit,
+                                      reference.data());
+        for (const auto &[tier, kernel] : runnableVariants(kernels)) {
+          size_t got = kernel(rows[0], rows[1], rows[2], begin, grid.cols(),
+                              '@', limit, found.data());
+          if (!std::ranges::equal(std::span(found).first(got),
+                                  std::span(reference).first(count))) {
+            return std::format(
+                "row {} from column {}, limit {}: scalar {}, {} {}", row,
+                begin, limit, listed(std::span(reference).first(count)), tier,
+                listed(std::span(found).first(got)));
+          }
+        }
+      }
+    }
+  }
+  return std::nullopt;
+}
+
+// ---------------------------------------------------------------------------
+// Day 9 point in polygon: the ray casting loop against the vector variants.
+// A case is the polygon's vertices, a blank line and the points to test.
+// ---------------------------------------------------------------------------
+
+std::string generatePolygon(Rng &rng, size_t size) {
+  std::string text = generated("day9", rng, size);
+  // Some slanted sides too, which the vector variants treat separately
+  if (gen::chance(rng, 50)) {
+    for (uint64_t n = gen::uniform(rng, 1, 3); n > 0; --n) {
+      text += std::format("{},{}\n", gen::uniform(rng, 0, size),
+                          gen::uniform(rng, 0, size));
+    }
+  }
+  text += "\n";
+  for (size_t i = 0; i < 4 * size; ++i) {
+    text += std::format("{},{}\n", gen::uniform(rng, 0, size + 2),
+                        gen::uniform(rng, 0, size + 2));
+  }
+  return text;
+}
+
+Mismatch checkPolygon(std::string_view text) {
+  using puzzles::day9::Point;
+  std::vector<Point> polygon;
+  std::vector<Point> points;
+  bool reading_points = false;
+  for (auto line : splitLines(text)) {
+    std::array<int64_t, 2> xy{};
+    auto fields = pc::parse_integers(line, std::span(xy));
+    if (line.empty()) {
+      reading_points = true;
+    } else if (fields && *fields == xy.size()) {
+      (reading_points ? points : polygon).push_back({xy[0], xy[1]});
+    }
+  }
+  if (polygon.empty()) {
+    return std::nullopt;
+  }
+  const puzzles::day9::PolygonSides sides(polygon);
+  const auto &variants = puzzles::day9::InsidePolygon;
+  for (const auto &point : points) {
+    bool reference = puzzles::day9::isInsidePolygon(sides, point);
+    for (const auto &[tier, inside] : runnableVariants(variants)) {
+      if (inside(sides, point) != reference) {
+        return std::format("point {},{}: scalar {}, {} {}", point.x, point.y,
+                           reference, tier, !reference);
+      }
+    }
+  }
+  return std::nullopt;
+}
+
+// ---------------------------------------------------------------------------
+// Day 5: the batch reader against reading the IDs one line at a time
+// ---------------------------------------------------------------------------
+
+// A day5 input with blank lines, some of them doubled, among the IDs
+std::string generateInventory(Rng &rng, size_t size) {
+  std::string text = generated("day5", rng, size);
+  const size_t ids = text.find("\n\n");
+  for (uint64_t n = gen::uniform(rng, 1, 4); n > 0 && ids != text.npos; --n) {
+    const size_t at =
+        text.rfind('\n', gen::uniform(rng, ids + 2, text.size() - 1)) + 1;
+    text.insert(at, gen::chance(rng, 30) ? "\n\n" : "\n");
+  }
+  return text;
+}
+
+Mismatch checkInventory(std::string_view text) {
+  std::vector<uint64_t> reference;
+  bool reading_ids = false;
+  for (auto line : splitLines(text)) {
+    if (line.empty()) {
+      reading_ids = true;
+    } else if (!reading_ids) {
+      if (!puzzles::day5::parseRange(line)) {
+        return std::nullopt;
+      }
+    } else {
+      auto id = pc::to_unsigned<uint64_t>(line);
+      if (!id) {
+        return std::nullopt;
+      }
+      reference.push_back(*id);
+    }
+  }
+
+  const auto path = std::filesystem::temp_directory_path() /
+                    std::format("puzzles_differential_{}.txt", ::getpid());
+  {
+    std::ofstream file(path, std::ios::binary);
+    file << text;
+  }
+  Mismatch mismatch;
+  for (size_t batch : {1, 3, 256}) {
+    auto inventory = puzzles::day5::readInventory(path, batch);
+    if (!inventory) {
+      mismatch = std::format("readInventory({}) failed", batch);
+    } else if (inventory->ids != reference) {
+      mismatch = std::format("readInventory({}): {} IDs, expected {}", batch,
+                             inventory->ids.size(), reference.size());
+    }
+    if (mismatch) {
+      break;
+    }
+  }
+  std::filesystem::remove(path);
+  return mismatch;
+}
+
+// ---------------------------------------------------------------------------
+// Readers: the mapped, batched, parallel and pipelined readers against
+// std::getline on the same file
+// ---------------------------------------------------------------------------
+
+std::string generateLines(Rng &rng, size_t size) {
+  constexpr std::string_view days[] = {"day1", "day3", "day5", "day7",
+                                       "day9", "day11"};
+  std::string text =
+      generated(days[gen::uniform(rng, 0, std::size(days) - 1)], rng, size);
+  // Blank lines, and a last line without its newline
+  for (uint64_t n = gen::uniform(rng, 0, 3); n > 0 && !text.empty(); --n) {
+    text.insert(text.rfind('\n', gen::uniform(rng, 0, text.size() - 1)) + 1,
+                "\n");
+  }
+  if (gen::chance(rng, 30) && !text.empty()) {
+    text.pop_back();
+  }
+  return text;
+}
+
+using Lines = std::vector<std::string>;
+
+Mismatch compareLines(std::string_view reader, const Lines &reference,
+                      const std::expected<Lines, bool> &lines) {
+  if (!lines) {
+    return std::format("{} failed", reader);
+  }
+  if (*lines == reference) {
+    return std::nullopt;
+  }
+  auto [ref, got] = std::ranges::mismatch(reference, *lines);
+  return std::format("{}: line {} is \"{}\", expected \"{}\" ({} vs {} lines)",
+                     reader, got - lines->begin(),
+                     got == lines->end() ? "<missing>" : *got,
+                     ref == reference.end() ? "<none>" : *ref, lines->size(),
+                     reference.size());
+}
+
+Mismatch checkReaders(std::string_view text) {
+  const auto path = std::filesystem::temp_directory_path() /
+                    std::format("puzzles_differential_{}.txt", ::getpid());
+  {
+    std::ofstream file(path, std::ios::binary);
+    file << text;
+  }
+  auto append = [](std::string_view line, Lines &lines) {
+    lines.emplace_back(line);
+    return true;
+  };
+  auto concat = [](Lines &into, Lines &&part) {
+    std::ranges::move(part, std::back_inserter(into));
+  };
+
+  Mismatch mismatch;
+  auto reference = pc::readFileByLine<Lines>(path, append);
+  auto check = [&](std::string_view reader,
+                   const std::expected<Lines, bool> &lines) {
+    if (!mismatch) {
+      mismatch = compareLines(reader, *reference, lines);
+    }
+  };
+  check("readFileByLineMapped", pc::readFileByLineMapped<Lines>(path, append));
+  for (size_t batch : {1, 3, 256}) {
+    check(std::format("readFileByBatch({})", batch),
+          pc::readFileByBatch<Lines>(
+              path,
+              [](std::span<const std::string_view> lines, Lines &into) {
+                into.insert(into.end(), lines.begin(), lines.end());
+                return true;
+              },
+              batch));
+  }
+  for (size_t threads : {1, 2, 3, 5}) {
+    check(std::format("readFileParallel({})", threads),
+          pc::readFileParallel<Lines>(path, append, concat,
+                                      pc::MergeOrder::Ordered, threads));
+  }
+  // Blocks smaller than a line make the read-ahead grow its buffers
+  for (size_t block_size : {8, 64, 1 << 20}) {
+    for (size_t batch : {1, 4}) {
+      check(std::format("readFilePipelined(block {}, batch {})", block_size,
+                        batch),
+            pc::readFilePipelined<std::string, Lines>(
+                path,
+                [](std::string_view line, std::vector<std::string> &records) {
+                  records.emplace_back(line);
+                  return true;
+                },
+                [](std::span<const std::string> records, Lines &lines) {
+                  lines.insert(lines.end(), records.begin(), records.end());
+                  return true;
+                },
+                concat,
+                pc::PipelineOptions{.workers = 1,
+                                    .batch_records = batch,
+                                    .block_size = block_size,
+                                    .blocks = 2}));
+    }
+  }
+  std::filesystem::remove(path);
+  return mismatch;
+}
+
+// Each engine shows up here as a property once it has a reference to be
+// checked against
+const std::vector<Property> properties{
+    {"dial_scan", "Day1 chunked scan against one move at a time",
+     generateMoves, checkDialScan},
+    {"dial_index", "Day1 window queries against replaying the window",
+     generateMoves, checkDialIndex},
+    {"day2_halves", "Day2 is_invalid against is_valid", generateIds,
+     checkIdHalves},
+    {"doubled_sums", "Day2 closed form sums against summing is_invalid",
+     generateIdRanges, checkDoubledSums},
+    {"repeated_sums", "Day2 table sums against summing is_invalid2",
+     generateRepeatedRanges, checkRepeatedSums},
+    {"digit_kernels", "Day2 string predicates against the digit kernels",
+     generateRepeatedRanges, checkDigitKernels},
+    {"to_unsigned", "from_chars against to_unsigned_swar", generateNumbers,
+     checkParsers},
+    {"tokenizer", "parse_integers against istringstream", generateTokens,
+     checkTokens},
+    {"class_scan", "scalar class scans against the vector ones",
+     generateTokens, checkScans},
+    {"sparse_cells", "Day4 neighbour counts across CPU tiers", generateGrid,
+     checkSparseCells},
+    {"inventory", "Day5 batch reader against one ID per line",
+     generateInventory, checkInventory},
+    {"polygon", "Day9 point in polygon across CPU tiers", generatePolygon,
+     checkPolygon},
+    {"readers", "file readers against std::getline", generateLines,
+     checkReaders},
+};
+
+// Smallest case that still fails: chunks of lines are dropped, halving the
+// chunk size down to single lines, then single characters
+std::string shrink(const Property &property, std::string text) {
+  auto fails = [&property](const std::string &candidate) {
+    return property.check(candidate).has_value();
+  };
+
+  std::vector<std::string> lines;
+  for (auto line : splitLines(text)) {
+    lines.emplace_back(line);
+  }
+  for (size_t chunk = std::max<size_t>(lines.size() / 2, 1);; chunk /= 2) {
+    for (size_t begin = 0; begin < lines.size();) {
+      std::vector<std::string> candidate(lines.begin(), lines.begin() + begin);
+      candidate.insert(candidate.end(),
+                       lines.begin() + std::min(begin + chunk, lines.size()),
+                       lines.end());
+      std::string joined;
+      for (const auto &line : candidate) {
+        joined += line + "\n";
+      }
+      if (fails(joined)) {
+        lines = std::move(candidate);
+        text = std::move(joined);
+      } else {
+        begin += chunk;
+      }
+    }
+    if (chunk == 1) {
+      break;
+    }
+  }
+
+  for (size_t pos = 0; pos < text.size();) {
+    std::string candidate = text;
+    candidate.erase(pos, 1);
+    if (fails(candidate)) {
+      text = std::move(candidate);
+    } else {
+      ++pos;
+    }
+  }
+  return text;
+}
+
+// Runs `cases` cases of growing size; prints and returns false on the first
+// mismatch
+bool run(const Property &property, uint64_t seed, size_t cases) {
+  Rng rng(seed);
+  for (size_t index = 0; index < cases; ++index) {
+    const size_t size = 1 + index * 64 / cases;
+    std::string text = property.generate(rng, size);
+    if (!property.check(text)) {
+      continue;
+    }
+    std::println("{}: mismatch in case {} of seed {}", property.name, index,
+                 seed);
+    std::string shrunk = shrink(property, text);
+    std::println("shrunk from {} to {} bytes:\n{}", text.size(), shrunk.size(),
+                 shrunk);
+    std::println("{}", property.check(shrunk).value_or(
+                           "(passes once shrunk: order dependent)"));
+    return false;
+  }
+  std::println("{}: {} cases passed", property.name, cases);
+  return true;
+}
+} // namespace
+
+int main(int argc, char *argv[]) {
+  uint64_t seed = 1;
+  size_t cases = 200;
+  std::vector<const Property *> selected;
+  for (int i = 1; i < argc; ++i) {
+    std::string_view arg = argv[i];
+    if (arg == "--list") {
+      for (const auto &property : properties) {
+        std::println("{:<14} {}", property.name, property.description);
+      }
+      return 0;
+    }
+    if ((arg == "--seed" || arg == "--cases") && i + 1 < argc) {
+      auto value = pc::to_unsigned<uint64_t>(argv[++i]);
+      if (!value) {
+        std::println(stderr, "Invalid value for {}: {}", arg, argv[i]);
+        return 1;
+      }
+      (arg == "--seed" ? seed : cases) = *value;
+      continue;
+    }
+    auto it = std::ranges::find(properties, arg, &Property::name);
+    if (it == properties.end()) {
+      std::println(stderr, "Unknown property: {}", arg);
+      return 1;
+    }
+    selected.push_back(&*it);
+  }
+  if (selected.empty()) {
+    for (const auto &property : properties) {
+      selected.push_back(&property);
+    }
+  }
+
+  bool passed = true;
+  for (const auto *property : selected) {
+    passed = run(*property, seed, cases) && passed;
+  }
+  return passed ? 0 : 1;
+}
@@ -0,0 +1,64 @@
+# Binary size and compile time per puzzle for the build_report target:
+#   cmake -DTARGETS=<file> -DLOG=<file> -DOUTPUT=<file> -DEMBED=<ON|OFF>
+#         -P build_report.cmake
+# TARGETS holds "<name>\t<executable>" lines, LOG the compile times written
+# by compile_timer.cmake. A puzzle's compile time is that of its solver
+# object; run it once per PUZZLES_EMBED_INPUT setting to compare the modes.
+
+function(pad_left value width out)
+    string(LENGTH "${value}" length)
+    while(length LESS width)
+        string(PREPEND value " ")
+        math(EXPR length "${length} + 1")
+    endwhile()
+    set(${out} "${value}" PARENT_SCOPE)
+endfunction()
+
+set(times)
+if(EXISTS "${LOG}")
+    file(STRINGS "${LOG}" times)
+endif()
+
+file(STRINGS "${TARGETS}" targets)
+set(report "embedded inputs: ${EMBED}\n")
+string(APPEND report "puzzle              binary bytes  compile ms\n")
+set(total_size 0)
+set(total_ms 0)
+foreach(line IN LISTS targets)
+    string(REPLACE "\t" ";" fields "${line}")
+    list(GET fields 0 name)
+    list(GET fields 1 executable)
+
+    file(SIZE "${executable}" size)
+    set(compile_ms 0)
+    set(compiled FALSE)
+    foreach(entry IN LISTS times)
+        if(entry MATCHES "/${name}_solver\\.dir/.*\t([0-9]+)$")
+            math(EXPR compile_ms "${compile_ms} + ${CMAKE_MATCH_1}")
+            set(compiled TRUE)
+        endif()
+    endforeach()
+    math(EXPR total_size "${total_size} + ${size}")
+    if(compiled)
+        math(EXPR total_ms "${total_ms} + ${compile_ms}")
+    else()
+        set(compile_ms "-")
+    endif()
+
+    string(LENGTH "${name}" length)
+    math(EXPR spaces "20 - ${length}")
+    string(REPEAT " " ${spaces} gap)
+    pad_left("${size}" 12 size_column)
+    pad_left("${compile_ms}" 12 time_column)
+    string(APPEND report "${name}${gap}${size_column}${time_column}\n")
+endforeach()
+pad_left("${total_size}" 12 size_column)
+pad_left("${total_ms}" 12 time_column)
+string(APPEND report "total               ${size_column}${time_column}\n")
+
+if(NOT times)
+    string(APPEND report
+        "no compile times; configure with -DPUZZLES_BUILD_REPORT=ON and "
+        "rebuild\n")
+endif()
+file(WRITE "${OUTPUT}" "${report}")
@@ -0,0 +1,33 @@
+# Compiler launcher for -DPUZZLES_BUILD_REPORT=ON:
+#   cmake -DLOG=<file> -P compile_timer.cmake -- <compiler command...>
+# Runs the command and appends "<object file>\t<milliseconds>" to LOG.
+
+set(command)
+set(after_separator FALSE)
+set(object "")
+set(next_is_object FALSE)
+math(EXPR last "${CMAKE_ARGC} - 1")
+foreach(index RANGE ${last})
+    set(argument "${CMAKE_ARGV${index}}")
+    if(after_separator)
+        list(APPEND command "${argument}")
+        if(next_is_object)
+            set(object "${argument}")
+        endif()
+        string(COMPARE EQUAL "${argument}" "-o" next_is_object)
+    elseif(argument STREQUAL "--")
+        set(after_separator TRUE)
+    endif()
+endforeach()
+
+string(TIMESTAMP start "%s%f")
+execute_process(COMMAND ${command} RESULT_VARIABLE result)
+string(TIMESTAMP finish "%s%f")
+math(EXPR elapsed_ms "(${finish} - ${start}) / 1000")
+
+if(result EQUAL 0)
+    file(LOCK "${LOG}.lock" GUARD FILE)
+    file(APPEND "${LOG}" "${object}\t${elapsed_ms}\n")
+else()
+    message(FATAL_ERROR "Compile failed: ${result}")
+endif()
@@ -0,0 +1,88 @@
+/*
+ * Synthetic input generators
+ * Writes a valid input of arbitrary size for any day, so the benchmarks and
+ * profiles can measure how the solutions scale beyond the checked-in inputs.
+ * The same seed and parameters always produce the same file.
+ * Usage:
+ *   generate --list
+ *   generate <day> [--seed N] [--out file] [param=value ...]
+ * Example:
+ *   generate day8 --seed 7 points=20000 > /tmp/day8_20k
+ */
+
+#include "../common/common.h"
+#include "generators.h"
+#include <cstdio>
+#include <print>
+#include <string_view>
+
+namespace {
+namespace pc = puzzles::common;
+namespace gen = puzzles::generators;
+} // namespace
+
+int main(int argc, char *argv[]) {
+  if (argc < 2) {
+    std::println(stderr, "Usage: generate --list | generate <day> [--seed N] "
+                         "[--out file] [param=value ...]");
+    return 1;
+  }
+
+  std::string_view day = argv[1];
+  if (day == "--list") {
+    for (const auto &generator : gen::generators()) {
+      std::print("{:<6} {:<22}", generator.name, generator.description);
+      for (const auto &[name, value] : generator.defaults) {
+        std::print(" {}={}", name, value);
+      }
+      std::println("");
+    }
+    return 0;
+  }
+
+  const auto *generator = gen::findGenerator(day);
+  if (!generator) {
+    std::println(stderr, "Unknown day: {}", day);
+    return 1;
+  }
+
+  gen::Params params(generator->defaults);
+  uint64_t seed = 1;
+  const char *out_path = nullptr;
+  for (int i = 2; i < argc; ++i) {
+    std::string_view arg = argv[i];
+    if (arg == "--seed" && i + 1 < argc) {
+      auto value = pc::to_unsigned<uint64_t>(argv[++i]);
+      if (!value) {
+        std::println(stderr, "Invalid seed: {}", argv[i]);
+        return 1;
+      }
+      seed = *value;
+    } else if (arg == "--out" && i + 1 < argc) {
+      out_path = argv[++i];
+    } else {
+      auto eq = arg.find('=');
+      auto value = eq == std::string_view::npos
+                       ? std::expected<uint64_t, std::errc>(
+                             std::unexpected(std::errc::invalid_argument))
+                       : pc::to_unsigned<uint64_t>(arg.substr(eq + 1));
+      if (!value || !params.set(arg.substr(0, eq), *value)) {
+        std::println(stderr, "Invalid parameter for {}: {}", day, arg);
+        return 1;
+      }
+    }
+  }
+
+  std::FILE *out = out_path ? std::fopen(out_path, "w") : stdout;
+  if (!out) {
+    std::println(stderr, "Cannot open {}", out_path);
+    return 1;
+  }
+  gen::Rng rng(seed);
+  generator->generate(rng, params, out);
+  if (out != stdout && std::fclose(out) != 0) {
+    std::println(stderr, "Error writing {}", out_path);
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,429 @@
+#pragma once
+
+// Synthetic input generators shared by tools/generate.cpp and the
+// differential tests: each writes a valid input for its day, sized by named
+// parameters. The same seed and parameters always produce the same text.
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <numeric>
+#include <print>
+#include <random>
+#include <ranges>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace puzzles::generators {
+
+using Rng = std::mt19937_64;
+using Param = std::pair<std::string_view, uint64_t>;
+
+// Parameters of one run: the generator defaults overridden from the command
+// line, looked up by name.
+class Params {
+  std::vector<Param> values_;
+
+public:
+  explicit Params(std::vector<Param> defaults) : values_(std::move(defaults)) {}
+
+  bool set(std::string_view name, uint64_t value) {
+    auto it = std::ranges::find(values_, name, &Param::first);
+    if (it == values_.end()) {
+      return false;
+    }
+    it->second = value;
+    return true;
+  }
+
+  uint64_t operator[](std::string_view name) const {
+    return std::ranges::find(values_, name, &Param::first)->second;
+  }
+};
+
+inline uint64_t uniform(Rng &rng, uint64_t lo, uint64_t hi) {
+  return std::uniform_int_distribution<uint64_t>(lo, hi)(rng);
+}
+
+inline bool chance(Rng &rng, uint64_t percent) {
+  return uniform(rng, 0, 99) < percent;
+}
+
+constexpr uint64_t pow10(uint64_t exponent) {
+  uint64_t value = 1;
+  while (exponent-- > 0) {
+    value *= 10;
+  }
+  return value;
+}
+
+// Day 1: dial rotations "L<n>" / "R<n>"
+inline void day1(Rng &rng, const Params &p, std::FILE *out) {
+  for (uint64_t i = 0; i < p["moves"]; ++i) {
+    std::println(out, "{}{}", chance(rng, 50) ? 'L' : 'R',
+                 uniform(rng, 1, p["max_distance"]));
+  }
+}
+
+// Day 2: one line of comma separated "first-last" ID ranges
+inline void day2(Rng &rng, const Params &p, std::FILE *out) {
+  const uint64_t max_digits = std::clamp<uint64_t>(p["digits"], 1, 18);
+  for (uint64_t i = 0; i < p["ranges"]; ++i) {
+    uint64_t digits = uniform(rng, 1, max_digits);
+    uint64_t low = digits == 1 ? 1 : pow10(digits - 1);
+    uint64_t first = uniform(rng, low, pow10(digits) - 1);
+    std::print(out, "{}{}-{}", i ? "," : "", first,
+               first + uniform(rng, 0, p["width"]));
+  }
+  std::println(out, "");
+}
+
+// Day 3: banks of battery joltage digits 1-9
+inline void day3(Rng &rng, const Params &p, std::FILE *out) {
+  std::string bank(std::max<uint64_t>(p["length"], 12), '1');
+  for (uint64_t i = 0; i < p["banks"]; ++i) {
+    for (auto &c : bank) {
+      c = static_cast<char>('1' + uniform(rng, 0, 8));
+    }
+    std::println(out, "{}", bank);
+  }
+}
+
+// Day 4: paper roll grid, '@' with the given density in percent
+inline void day4(Rng &rng, const Params &p, std::FILE *out) {
+  std::string row(p["width"], '.');
+  for (uint64_t y = 0; y < p["height"]; ++y) {
+    for (auto &c : row) {
+      c = chance(rng, p["density"]) ? '@' : '.';
+    }
+    std::println(out, "{}", row);
+  }
+}
+
+// Day 5: fresh ID ranges, a blank line, then available IDs
+inline void day5(Rng &rng, const Params &p, std::FILE *out) {
+  const uint64_t max_id = p["max_id"];
+  for (uint64_t i = 0; i < p["ranges"]; ++i) {
+    uint64_t first = uniform(rng, 1, max_id);
+    std::println(out, "{}-{}", first,
+                 std::min(max_id, first + uniform(rng, 0, p["width"])));
+  }
+  std::println(out, "");
+  for (uint64_t i = 0; i < p["ids"]; ++i) {
+    std::println(out, "{}", uniform(rng, 1, max_id));
+  }
+}
+
+// Day 6: worksheet of vertical problems; every problem is a block of
+// columns as wide as its longest number, blocks are separated by one blank
+// column and numbers are aligned left or right inside their block
+inline void day6(Rng &rng, const Params &p, std::FILE *out) {
+  const uint64_t rows = std::max<uint64_t>(p["rows"], 1);
+  const uint64_t max_digits = std::clamp<uint64_t>(p["digits"], 1, 4);
+  std::vector<std::string> lines(rows + 1);
+  for (uint64_t problem = 0; problem < p["problems"]; ++problem) {
+    std::vector<std::string> numbers(rows);
+    size_t width = 0;
+    for (auto &number : numbers) {
+      number = std::to_string(
+          uniform(rng, 1, pow10(uniform(rng, 1, max_digits)) - 1));
+      width = std::max(width, number.size());
+    }
+    const bool align_left = chance(rng, 50);
+    for (uint64_t row = 0; row < rows; ++row) {
+      std::string cell(width, ' ');
+      cell.replace(align_left ? 0 : width - numbers[row].size(),
+                   numbers[row].size(), numbers[row]);
+      lines[row] += (problem ? " " : "") + cell;
+    }
+    std::string op(width, ' ');
+    op[0] = chance(rng, 50) ? '+' : '*';
+    lines[rows] += (problem ? " " : "") + op;
+  }
+  for (const auto &line : lines) {
+    std::println(out, "{}", line);
+  }
+}
+
+// Day 7: W x H tachyon manifold, 'S' in the middle of the top row and
+// splitters on every other row with the given density in percent
+inline void day7(Rng &rng, const Params &p, std::FILE *out) {
+  const uint64_t width = std::max<uint64_t>(p["width"], 3);
+  std::string row(width, '.');
+  row[width / 2] = 'S';
+  std::println(out, "{}", row);
+  for (uint64_t y = 1; y < p["height"]; ++y) {
+    for (uint64_t x = 0; x < width; ++x) {
+      row[x] = y % 2 == 0 && x > 0 && x + 1 < width && chance(rng, p["density"])
+                   ? '^'
+                   : '.';
+    }
+    std::println(out, "{}", row);
+  }
+}
+
+// Day 8: N junction boxes as "x,y,z"
+inline void day8(Rng &rng, const Params &p, std::FILE *out) {
+  for (uint64_t i = 0; i < p["points"]; ++i) {
+    std::println(out, "{},{},{}", uniform(rng, 0, p["coord"]),
+                 uniform(rng, 0, p["coord"]), uniform(rng, 0, p["coord"]));
+  }
+}
+
+// Day 9: rectilinear polygon with V vertices in drawing order. The shape is
+// a skyline: a flat bottom edge and (V - 2) / 2 columns of random height.
+inline void day9(Rng &rng, const Params &p, std::FILE *out) {
+  const uint64_t columns = std::max<uint64_t>(p["vertices"], 4) / 2 - 1;
+  const uint64_t coord = std::max(p["coord"], 4 * columns);
+
+  // Strictly increasing x edges and heights that differ between neighbours,
+  // so no two consecutive vertices coincide
+  const uint64_t max_gap = std::max<uint64_t>(coord / (columns + 1), 1);
+  std::vector<uint64_t> xs(columns + 1, 1);
+  for (uint64_t i = 1; i <= columns; ++i) {
+    xs[i] = xs[i - 1] + uniform(rng, 1, max_gap);
+  }
+  std::vector<uint64_t> heights(columns);
+  for (uint64_t i = 0; i < columns; ++i) {
+    do {
+      heights[i] = uniform(rng, 2, coord);
+    } while (i > 0 && heights[i] == heights[i - 1]);
+  }
+
+  std::println(out, "{},{}", xs.front(), 1);
+  std::println(out, "{},{}", xs.back(), 1);
+  for (uint64_t i = columns; i-- > 0;) {
+    std::println(out, "{},{}", xs[i + 1], heights[i]);
+    std::println(out, "{},{}", xs[i], heights[i]);
+  }
+}
+
+// Day 10: machines with L lights and B buttons. The light pattern is the
+// XOR of a random button subset and the joltage targets are the counter
+// sums of random press counts, so both parts always have a solution.
+inline void day10(Rng &rng, const Params &p, std::FILE *out) {
+  const uint64_t lights = std::clamp<uint64_t>(p["lights"], 1, 64);
+  const uint64_t buttons = std::max<uint64_t>(p["buttons"], 1);
+  std::vector<uint64_t> order(lights);
+  std::iota(order.begin(), order.end(), 0);
+
+  for (uint64_t m = 0; m < p["machines"]; ++m) {
+    std::string pattern(lights, '.');
+    std::string wiring;
+    std::vector<uint64_t> joltage(lights, 0);
+    for (uint64_t b = 0; b < buttons; ++b) {
+      std::ranges::shuffle(order, rng);
+      std::vector<uint64_t> wired(order.begin(),
+                                  order.begin() + uniform(rng, 1, lights));
+      std::ranges::sort(wired);
+
+      const bool toggled = chance(rng, 50);
+      const uint64_t presses = uniform(rng, 0, p["presses"]);
+      wiring += " (";
+      for (auto [idx, light] : wired | std::views::enumerate) {
+        wiring += (idx ? "," : "") + std::to_string(light);
+        if (toggled) {
+          pattern[light] = pattern[light] == '.' ? '#' : '.';
+        }
+        joltage[light] += presses;
+      }
+      wiring += ")";
+    }
+    std::string targets;
+    for (auto [idx, value] : joltage | std::views::enumerate) {
+      targets += (idx ? "," : "") + std::to_string(value);
+    }
+    std::println(out, "[{}]{} {{{}}}", pattern, wiring, targets);
+  }
+}
+
+// Day 11: DAG of N devices. Edges only point to later devices in a hidden
+// order, picked uniformly, which keeps path counts polynomial in N.
+// "svr" is first, "you" early, "dac" and "fft" in between and "out" last.
+inline void day11(Rng &rng, const Params &p, std::FILE *out) {
+  const uint64_t nodes = std::max<uint64_t>(p["nodes"], 8);
+
+  // Unique lowercase names, three letters while they fit
+  size_t letters = 3;
+  while (std::pow(26.0, letters) < 2.0 * nodes) {
+    ++letters;
+  }
+  auto random_name = [&] {
+    std::string name(letters, 'a');
+    for (auto &c : name) {
+      c = static_cast<char>('a' + uniform(rng, 0, 25));
+    }
+    return name;
+  };
+  std::vector<std::string> names(nodes);
+  std::vector<std::string> used{"svr", "you", "dac", "fft", "out"};
+  for (auto &name : names) {
+    do {
+      name = random_name();
+    } while (std::ranges::find(used, name) != used.end());
+    used.push_back(name);
+  }
+  names.front() = "svr";
+  names.back() = "out";
+  const uint64_t you = uniform(rng, 1, nodes / 4);
+  const uint64_t dac = uniform(rng, nodes / 4 + 1, nodes / 2);
+  const uint64_t fft = uniform(rng, nodes / 2 + 1, 3 * nodes / 4);
+  names[you] = "you";
+  names[dac] = "dac";
+  names[fft] = "fft";
+
+  std::vector<std::string> lines;
+  lines.reserve(nodes - 1);
+  for (uint64_t i = 0; i + 1 < nodes; ++i) {
+    // svr -> dac -> fft is wired directly so part 2 always has a path
+    std::vector<uint64_t> targets;
+    if (i == 0 || i == dac) {
+      targets.push_back(i == 0 ? dac : fft);
+    }
+    const uint64_t degree = uniform(rng, 1, std::max<uint64_t>(p["degree"], 1));
+    while (targets.size() < std::min(degree, nodes - 1 - i)) {
+      uint64_t target = uniform(rng, i + 1, nodes - 1);
+      if (std::ranges::find(targets, target) == targets.end()) {
+        targets.push_back(target);
+      }
+    }
+    std::string line = names[i] + ":";
+    for (auto target : targets) {
+      line += " " + names[target];
+    }
+    lines.push_back(std::move(line));
+  }
+  std::ranges::shuffle(lines, rng);
+  for (const auto &line : lines) {
+    std::println(out, "{}", line);
+  }
+}
+
+// Day 12: present shapes on a 3x3 grid followed by regions. Like the real
+// input, a region either has room for every present in its own 3x3 cell
+// or needs more cells than it has.
+inline void day12(Rng &rng, const Params &p, std::FILE *out) {
+  const uint64_t shapes = std::max<uint64_t>(p["shapes"], 1);
+  uint64_t min_cells = 9;
+  for (uint64_t s = 0; s < shapes; ++s) {
+    std::println(out, "{}:", s);
+    std::array<char, 9> cells{};
+    cells.fill('#');
+    // Clear up to three cells, keeping the centre so the shape stays whole
+    for (uint64_t k = uniform(rng, 1, 3); k > 0; --k) {
+      size_t cell = uniform(rng, 0, 8);
+      if (cell != 4) {
+        cells[cell] = '.';
+      }
+    }
+    min_cells = std::min<uint64_t>(min_cells, std::ranges::count(cells, '#'));
+    for (size_t row = 0; row < 3; ++row) {
+      std::println(out, "{}", std::string_view(cells.data() + 3 * row, 3));
+    }
+    std::println(out, "");
+  }
+
+  for (uint64_t r = 0; r < p["regions"]; ++r) {
+    const uint64_t width = uniform(rng, 6, std::max<uint64_t>(p["size"], 6));
+    const uint64_t height = uniform(rng, 6, std::max<uint64_t>(p["size"], 6));
+    // Fitting regions get at most one present per 3x3 cell, the others
+    // more present cells than the region has, even with the smallest shape
+    const uint64_t pieces = chance(rng, 50)
+                                ? uniform(rng, 1, (width / 3) * (height / 3))
+                                : width * height / min_cells + 1;
+    std::vector<uint64_t> counts(shapes, 0);
+    for (uint64_t i = 0; i < pieces; ++i) {
+      ++counts[uniform(rng, 0, shapes - 1)];
+    }
+    std::print(out, "{}x{}:", width, height);
+    for (auto count : counts) {
+      std::print(out, " {}", count);
+    }
+    std::println(out, "");
+  }
+}
+
+struct Generator {
+  std::string_view name;
+  std::string_view description;
+  std::vector<Param> defaults;
+  void (*generate)(Rng &rng, const Params &params, std::FILE *out);
+};
+
+// Defaults reproduce the size of the checked-in inputs
+inline const std::vector<Generator> &generators() {
+  static const std::vector<Generator> table{
+      {"day1",
+       "dial rotations",
+       {{"moves", 4145}, {"max_distance", 999}},
+       day1},
+      {"day2",
+       "ID ranges on one line",
+       {{"ranges", 38}, {"width", 200000}, {"digits", 10}},
+       day2},
+      {"day3", "joltage banks", {{"banks", 200}, {"length", 100}}, day3},
+      {"day4",
+       "paper roll grid",
+       {{"width", 137}, {"height", 137}, {"density", 60}},
+       day4},
+      {"day5",
+       "fresh ranges and IDs",
+       {{"ranges", 182},
+        {"ids", 1000},
+        {"max_id", 560000000000000},
+        {"width", 20000000000000}},
+       day5},
+      {"day6",
+       "vertical worksheet",
+       {{"problems", 1000}, {"rows", 4}, {"digits", 4}},
+       day6},
+      {"day7",
+       "tachyon manifold",
+       {{"width", 141}, {"height", 142}, {"density", 20}},
+       day7},
+      {"day8", "3D junction boxes", {{"points", 1000}, {"coord", 99999}}, day8},
+      {"day9",
+       "rectilinear polygon",
+       {{"vertices", 496}, {"coord", 100000}},
+       day9},
+      {"day10",
+       "machines",
+       {{"machines", 199}, {"lights", 8}, {"buttons", 8}, {"presses", 40}},
+       day10},
+      {"day11", "device DAG", {{"nodes", 588}, {"degree", 4}}, day11},
+      {"day12",
+       "shapes and regions",
+       {{"shapes", 6}, {"regions", 1000}, {"size", 50}},
+       day12},
+  };
+  return table;
+}
+
+// Text of a generated input, e.g. for tests that never touch the disk
+inline std::string generateText(const Generator &generator, Rng &rng,
+                                const Params &params) {
+  char *data = nullptr;
+  size_t size = 0;
+  std::FILE *out = open_memstream(&data, &size);
+  if (!out) {
+    return {};
+  }
+  generator.generate(rng, params, out);
+  std::fclose(out);
+  std::string text(data, size);
+  std::free(data);
+  return text;
+}
+
+// Generator of a day by name, or nullptr
+inline const Generator *findGenerator(std::string_view name) {
+  auto it = std::ranges::find(generators(), name, &Generator::name);
+  return it == generators().end() ? nullptr : &*it;
+}
+
+} // namespace puzzles::generators